@@ -28,17 +28,30 @@
       'sources': [
 	'../src/break-iterator.cc',
 	'../src/break-iterator.h',
+        '../src/break-iterator-pool.cc',
+        '../src/break-iterator-pool.h',
         '../include/extension.h',
         '../src/collator.cc',
         '../src/collator.h',
         '../src/date-format.cc',
         '../src/date-format.h',
         '../src/extension.cc',
+        '../src/isolate-data.cc',
+        '../src/isolate-data.h',
+        '../src/language-tag.cc',
+        '../src/language-tag.h',
         '../src/locale.cc',
         '../src/locale.h',
+        '../src/locale-matcher.cc',
+        '../src/locale-matcher.h',
+        '../src/lru-cache.h',
         '../src/natives.h',
         '../src/number-format.cc',
         '../src/number-format.h',
+        '../src/option-resolver.cc',
+        '../src/option-resolver.h',
+        '../src/property-names.cc',
+        '../src/property-names.h',
         '../src/utils.cc',
         '../src/utils.h',
         '<(SHARED_INTERMEDIATE_DIR)/v8-i18n-js.cc',
@@ -57,6 +70,16 @@
           '../..',
         ],
       },
+      'conditions': [
+        ['OS!="win"', {
+          # Parallel segmentation runs on worker threads.
+          'link_settings': {
+            'libraries': [
+              '-lpthread',
+            ],
+          },
+        }],
+      ],
     },
     {
       'target_name': 'api2c',
@@ -75,6 +98,13 @@
           '../src/overrides.js',
 	  '../src/footer.js'
         ],
+        # Services installed on first use of their constructor.
+        'lazy_js_files': [
+          '../src/collator.js',
+          '../src/number-format.js',
+          '../src/date-format.js',
+          '../src/break-iterator.js',
+        ],
       },
       'actions': [
         {
@@ -94,6 +124,9 @@
             'python',
             '../tools/js2c.py',
             '<@(_outputs)',
+            '--lazy',
+            '<@(lazy_js_files)',
+            '--',
             '<@(js_files)'
           ],
         },
@@ -27,9 +27,48 @@ class Extension : public v8::Extension {
       v8::Handle<v8::String> name);
 
   // V8 code prefers Register, while Chrome and WebKit use get kind of methods.
+  // Either has to be called once, before isolates are started on other
+  // threads.
   static void Register();
   static Extension* get();
 
+  // Sets the isolate data slot the extension keeps its per isolate caches
+  // in. Defaults to the last slot. Has to be called before the extension is
+  // used in any isolate.
+  static void SetIsolateDataSlot(uint32_t slot);
+
+  // Deletes caches and templates the extension created for the isolate.
+  // Call it with the isolate entered, after its last context is gone and
+  // before the isolate is disposed. Break iterators and collators that
+  // weren't collected yet keep the ICU data they use, until they are.
+  // Isolates may run the extension concurrently, each on its own thread.
+  static void DisposeIsolateData(v8::Isolate* isolate);
+
+  // Sets how many released break iterators are kept for reuse per locale
+  // and type, in each isolate. Default is 8, zero disables reuse.
+  static void SetBreakIteratorPoolLimit(int limit);
+
+  // Sets how many segmented texts are cached per locale and type, so
+  // adopting a text seen before doesn't segment it again. Only short texts
+  // are cached. Default is zero, which disables the cache.
+  static void SetBreakIteratorCacheSize(int size);
+
+  // Loads compiled break rules, as returned by v8BreakIterator's
+  // v8BinaryRules(), so v8BinaryRules options with the same bytes are
+  // accepted in every isolate, without compiling rule source. ICU doesn't
+  // validate compiled rules, and they only load in the ICU version that
+  // compiled them, so pass only data the embedder shipped or saved itself.
+  // Has to be called before isolates are started on other threads.
+  // Returns false if ICU can't load the rules.
+  static bool RegisterBreakRules(const uint8_t* data, size_t length);
+
+  // Loads a collator binary image, as returned by Collator's
+  // v8BinaryRules(), on top of the root collator, so v8BinaryRules options
+  // with the same bytes are accepted in every isolate, without compiling
+  // tailoring rules. The same caveats as for RegisterBreakRules apply.
+  // Returns false if ICU can't load the image.
+  static bool RegisterCollatorRules(const uint8_t* data, size_t length);
+
  private:
   static Extension* extension_;
 };
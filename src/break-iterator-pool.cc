@@ -0,0 +1,428 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/break-iterator-pool.h"
+
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/isolate-data.h"
+#include "src/lru-cache.h"
+#include "src/utils.h"
+#include "unicode/brkiter.h"
+#include "unicode/locid.h"
+#include "unicode/rbbi.h"
+#include "unicode/utext.h"
+
+namespace v8_i18n {
+
+// Pools built from custom rules, keyed by rule source or by digest of the
+// compiled rules. Rules may come from web pages, so only the recently used
+// ones are kept.
+static const size_t kMaxCustomPools = 32;
+
+typedef std::map<std::string, BreakIteratorPool*> PoolMap;
+typedef LruCache<BreakIteratorPool*, kMaxCustomPools> CustomPoolCache;
+
+// Pools of one isolate. Each entry holds a reference to its pool.
+struct PoolCache {
+  PoolMap locale_pools;
+  CustomPoolCache custom_pools;
+};
+
+// Compiled rules the embedder registered, and an iterator loaded from
+// them. ICU doesn't copy compiled rules, so they stay here for the life of
+// the process, and pools of each isolate use clones of the iterator.
+struct RegisteredRules {
+  std::vector<uint8_t> binary;
+  icu::BreakIterator* prototype;
+};
+
+typedef std::map<std::string, RegisteredRules*> RegisteredRulesMap;
+
+// Only written before isolates start, so it's shared without locking.
+static RegisteredRulesMap* registered_rules = NULL;
+
+static PoolCache* GetPools();
+static void AddCustomPool(const std::string&, BreakIteratorPool*);
+static icu::BreakIterator* CreatePrototype(const icu::Locale&,
+                                           BreakIteratorPool::Type);
+
+// Default number of released iterators kept per locale and type.
+int32_t BreakIteratorPool::limit_ = 8;
+
+// Segmentation cache is off unless the embedder turns it on.
+int32_t BreakIteratorPool::cache_size_ = 0;
+
+// Longer texts are rarely repeated, and would take too much memory.
+static const int32_t kMaxCachedTextLength = 1024;
+
+BreakIteratorPool::BreakIteratorPool(icu::BreakIterator* prototype,
+                                     Type type)
+    : prototype_(prototype),
+      type_(type),
+      references_(0),
+      cache_hits_(0),
+      cache_misses_(0) {
+}
+
+BreakIteratorPool::~BreakIteratorPool() {
+  for (size_t i = 0; i < released_.size(); ++i) {
+    delete released_[i];
+  }
+
+  // Iterators still in use hold their own references.
+  for (SegmentationList::iterator it = lru_.begin(); it != lru_.end(); ++it) {
+    Unreference(*it);
+  }
+
+  delete prototype_;
+}
+
+// static
+BreakIteratorPool* BreakIteratorPool::Get(const icu::Locale& locale,
+                                          Type type) {
+  PoolMap* pools = &GetPools()->locale_pools;
+
+  std::string key(locale.getName());
+  key.push_back('/');
+  key.push_back(static_cast<char>('0' + type));
+
+  PoolMap::iterator it = pools->find(key);
+  if (it != pools->end()) {
+    return it->second;
+  }
+
+  icu::BreakIterator* prototype = CreatePrototype(locale, type);
+  if (!prototype) {
+    return NULL;
+  }
+
+  BreakIteratorPool* pool = new BreakIteratorPool(prototype, type);
+  pool->AddReference();
+  (*pools)[key] = pool;
+  return pool;
+}
+
+// static
+BreakIteratorPool* BreakIteratorPool::GetForRules(
+    const icu::UnicodeString& rules, UParseError* parse_error) {
+  // Rule source is the key, as raw UTF-16 bytes.
+  std::string key("rules/");
+  key.append(reinterpret_cast<const char*>(rules.getBuffer()),
+             rules.length() * sizeof(UChar));
+
+  BreakIteratorPool** cached = GetPools()->custom_pools.Find(key);
+  if (cached) {
+    return *cached;
+  }
+
+  UParseError error;
+  UErrorCode status = U_ZERO_ERROR;
+  icu::BreakIterator* prototype =
+      new icu::RuleBasedBreakIterator(rules, error, status);
+  if (U_FAILURE(status)) {
+    delete prototype;
+    if (parse_error) {
+      *parse_error = error;
+    }
+    return NULL;
+  }
+
+  BreakIteratorPool* pool = new BreakIteratorPool(prototype, CUSTOM);
+  AddCustomPool(key, pool);
+  return pool;
+}
+
+// static
+BreakIteratorPool* BreakIteratorPool::GetForBinaryRules(const uint8_t* data,
+                                                        int32_t length) {
+  if (!data || length <= 0) {
+    return NULL;
+  }
+
+  std::string key = Utils::BinaryKey(data, static_cast<uint32_t>(length));
+  BreakIteratorPool** cached = GetPools()->custom_pools.Find(key);
+  if (cached) {
+    // Digests are only an index, the rules have to be the same.
+    uint32_t pool_length = 0;
+    const uint8_t* pool_data = static_cast<icu::RuleBasedBreakIterator*>(
+        (*cached)->prototype_)->getBinaryRules(pool_length);
+    if (pool_length != static_cast<uint32_t>(length) ||
+        memcmp(pool_data, data, pool_length) != 0) {
+      return NULL;
+    }
+    return *cached;
+  }
+
+  if (!registered_rules) {
+    return NULL;
+  }
+  RegisteredRulesMap::const_iterator it = registered_rules->find(key);
+  if (it == registered_rules->end() ||
+      it->second->binary.size() != static_cast<size_t>(length) ||
+      memcmp(&it->second->binary[0], data, length) != 0) {
+    return NULL;
+  }
+
+  icu::BreakIterator* prototype = it->second->prototype->clone();
+  if (!prototype) {
+    return NULL;
+  }
+
+  BreakIteratorPool* pool = new BreakIteratorPool(prototype, CUSTOM);
+  AddCustomPool(key, pool);
+  return pool;
+}
+
+// static
+bool BreakIteratorPool::RegisterBinaryRules(const uint8_t* data,
+                                            size_t length) {
+  if (!data || length == 0 || length > 0x7FFFFFFF) {
+    return false;
+  }
+
+  std::string key = Utils::BinaryKey(data, static_cast<uint32_t>(length));
+  if (!registered_rules) {
+    registered_rules = new RegisteredRulesMap();
+  } else if (registered_rules->count(key)) {
+    // Either registered before, or another rule set with the same digest.
+    const std::vector<uint8_t>& binary = (*registered_rules)[key]->binary;
+    return binary.size() == length && memcmp(&binary[0], data, length) == 0;
+  }
+
+  RegisteredRules* rules = new RegisteredRules();
+  rules->binary.assign(data, data + length);
+  UErrorCode status = U_ZERO_ERROR;
+  rules->prototype = new icu::RuleBasedBreakIterator(
+      &rules->binary[0], static_cast<uint32_t>(length), status);
+  if (U_FAILURE(status)) {
+    delete rules->prototype;
+    delete rules;
+    return false;
+  }
+
+  (*registered_rules)[key] = rules;
+  return true;
+}
+
+const uint8_t* BreakIteratorPool::GetBinaryRules(uint32_t* length) {
+  // TODO(cira): Remove cast once ICU fixes base BreakIterator class.
+  const uint8_t* data = static_cast<icu::RuleBasedBreakIterator*>(
+      prototype_)->getBinaryRules(*length);
+  if (!data || *length == 0) {
+    return data;
+  }
+
+  std::string key = Utils::BinaryKey(data, *length);
+  if (!GetPools()->custom_pools.Find(key)) {
+    AddCustomPool(key, this);
+  }
+  return data;
+}
+
+void BreakIteratorPool::AddReference() {
+  ++references_;
+}
+
+// static
+void BreakIteratorPool::Unreference(BreakIteratorPool* pool) {
+  if (--pool->references_ == 0) {
+    delete pool;
+  }
+}
+
+// static
+void BreakIteratorPool::SetLimit(int32_t limit) {
+  // Pools trim themselves on the next release.
+  limit_ = limit < 0 ? 0 : limit;
+}
+
+icu::BreakIterator* BreakIteratorPool::Acquire() {
+  if (!released_.empty()) {
+    icu::BreakIterator* break_iterator = released_.back();
+    released_.pop_back();
+    return break_iterator;
+  }
+
+  return prototype_->clone();
+}
+
+void BreakIteratorPool::Release(icu::BreakIterator* break_iterator) {
+  while (static_cast<int32_t>(released_.size()) > limit_) {
+    delete released_.back();
+    released_.pop_back();
+  }
+
+  if (static_cast<int32_t>(released_.size()) == limit_) {
+    delete break_iterator;
+    return;
+  }
+
+  // Iterator references text owned by the JS object that's going away.
+  // Point it to static empty text instead.
+  static const UChar kEmptyText[] = {0};
+  UErrorCode status = U_ZERO_ERROR;
+  UText* empty_text = utext_openUChars(NULL, kEmptyText, 0, &status);
+  break_iterator->setText(empty_text, status);
+  utext_close(empty_text);
+  if (U_FAILURE(status)) {
+    delete break_iterator;
+    return;
+  }
+
+  released_.push_back(break_iterator);
+}
+
+// static
+void BreakIteratorPool::SetCacheSize(int32_t size) {
+  // Caches trim themselves on the next miss.
+  cache_size_ = size < 0 ? 0 : size;
+}
+
+Segmentation* BreakIteratorPool::Segment(const icu::UnicodeString& text,
+                                         icu::BreakIterator* break_iterator) {
+  if (cache_size_ == 0 || text.length() > kMaxCachedTextLength) {
+    return NULL;
+  }
+
+  int32_t hash = text.hashCode();
+  SegmentationMap::iterator it = cache_.find(hash);
+  if (it != cache_.end() && (*it->second)->text == text) {
+    ++cache_hits_;
+    // Move the entry to the front.
+    lru_.splice(lru_.begin(), lru_, it->second);
+    Segmentation* segmentation = lru_.front();
+    ++segmentation->references;
+    return segmentation;
+  }
+
+  ++cache_misses_;
+
+  // Entry with the same hash but different text gets replaced.
+  if (it != cache_.end()) {
+    Unreference(*it->second);
+    lru_.erase(it->second);
+    cache_.erase(it);
+  }
+
+  Segmentation* segmentation = new Segmentation();
+  segmentation->text = text;
+  // One reference for the cache, one for the caller.
+  segmentation->references = 2;
+
+  // TODO(cira): Remove cast once ICU fixes base BreakIterator class.
+  icu::RuleBasedBreakIterator* rule_based_iterator =
+      static_cast<icu::RuleBasedBreakIterator*>(break_iterator);
+  for (int32_t position = break_iterator->first();
+       position != icu::BreakIterator::DONE;
+       position = break_iterator->next()) {
+    segmentation->positions.push_back(position);
+    segmentation->statuses.push_back(rule_based_iterator->getRuleStatus());
+  }
+  break_iterator->first();
+
+  lru_.push_front(segmentation);
+  cache_[hash] = lru_.begin();
+
+  while (static_cast<int32_t>(lru_.size()) > cache_size_) {
+    Segmentation* evicted = lru_.back();
+    cache_.erase(evicted->text.hashCode());
+    lru_.pop_back();
+    Unreference(evicted);
+  }
+
+  return segmentation;
+}
+
+// static
+void BreakIteratorPool::Unreference(Segmentation* segmentation) {
+  if (--segmentation->references == 0) {
+    delete segmentation;
+  }
+}
+
+// Drops the cache's references. Pools still used by iterators live until
+// the last of them is collected.
+static void DeletePools(v8::Isolate* isolate, void* value) {
+  PoolCache* pools = static_cast<PoolCache*>(value);
+  for (PoolMap::iterator it = pools->locale_pools.begin();
+       it != pools->locale_pools.end(); ++it) {
+    BreakIteratorPool::Unreference(it->second);
+  }
+  BreakIteratorPool* pool = NULL;
+  while (pools->custom_pools.RemoveOldest(&pool)) {
+    BreakIteratorPool::Unreference(pool);
+  }
+  delete pools;
+}
+
+// Pools are kept per isolate, so iterators are never shared between
+// threads.
+static PoolCache* GetPools() {
+  IsolateData* data = IsolateData::Current();
+  PoolCache* pools =
+      static_cast<PoolCache*>(data->Get(IsolateData::BREAK_ITERATOR_POOLS));
+  if (!pools) {
+    pools = new PoolCache();
+    data->Set(IsolateData::BREAK_ITERATOR_POOLS, pools, &DeletePools);
+  }
+  return pools;
+}
+
+// Adds a custom pool under the key, which must not be cached yet, dropping
+// the least recently used one if the cache is full.
+static void AddCustomPool(const std::string& key, BreakIteratorPool* pool) {
+  BreakIteratorPool* evicted = NULL;
+  pool->AddReference();
+  *GetPools()->custom_pools.Insert(key, &evicted) = pool;
+  if (evicted) {
+    BreakIteratorPool::Unreference(evicted);
+  }
+}
+
+static icu::BreakIterator* CreatePrototype(const icu::Locale& icu_locale,
+                                           BreakIteratorPool::Type type) {
+  UErrorCode status = U_ZERO_ERROR;
+  icu::BreakIterator* break_iterator = NULL;
+  switch (type) {
+    case BreakIteratorPool::CHARACTER:
+      break_iterator =
+        icu::BreakIterator::createCharacterInstance(icu_locale, status);
+      break;
+    case BreakIteratorPool::SENTENCE:
+      break_iterator =
+        icu::BreakIterator::createSentenceInstance(icu_locale, status);
+      break;
+    case BreakIteratorPool::LINE:
+      break_iterator =
+        icu::BreakIterator::createLineInstance(icu_locale, status);
+      break;
+    default:
+      break_iterator =
+        icu::BreakIterator::createWordInstance(icu_locale, status);
+  }
+
+  if (U_FAILURE(status)) {
+    delete break_iterator;
+    return NULL;
+  }
+
+  return break_iterator;
+}
+
+}  // namespace v8_i18n
@@ -0,0 +1,151 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef V8_I18N_SRC_BREAK_ITERATOR_POOL_H_
+#define V8_I18N_SRC_BREAK_ITERATOR_POOL_H_
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "unicode/parseerr.h"
+#include "unicode/unistr.h"
+
+namespace U_ICU_NAMESPACE {
+class BreakIterator;
+class Locale;
+}
+
+namespace v8_i18n {
+
+// Boundaries of a text with rule statuses of each boundary. Shared between
+// the cache and the iterators that adopted the same text.
+struct Segmentation {
+  icu::UnicodeString text;
+  std::vector<int32_t> positions;
+  std::vector<int32_t> statuses;
+  int32_t references;
+};
+
+// Creating a break iterator loads rule data (and dictionaries for some
+// scripts), so we keep one prototype iterator per locale and type, and hand
+// out its clones. Released iterators are kept for reuse, up to a limit.
+// Pools belong to the current isolate, and are reference counted: the
+// isolate's cache holds one reference, and so does each iterator wrapper
+// built from the pool. Pools for custom rules drop out of the cache when
+// they weren't used for a while.
+class BreakIteratorPool {
+ public:
+  enum Type {
+    CHARACTER = 0,
+    WORD,
+    SENTENCE,
+    LINE,
+    // Built from custom rules, none of the type specific shortcuts apply.
+    CUSTOM,
+    TYPE_COUNT
+  };
+
+  // Returns the pool for a given locale and type, creating it on first use.
+  // Returns NULL if ICU can't create an iterator for the locale.
+  // Pools returned by Get* are only referenced by the cache, so callers
+  // that keep one have to add a reference before getting another pool.
+  static BreakIteratorPool* Get(const icu::Locale& locale, Type type);
+
+  // Returns the pool for iterators built from rule source. Rules are
+  // compiled once, as long as they stay in the cache. Returns NULL if the
+  // rules don't compile, and sets |parse_error|, unless it's NULL, to where
+  // compilation failed.
+  static BreakIteratorPool* GetForRules(const icu::UnicodeString& rules,
+                                        UParseError* parse_error);
+
+  // Returns the pool for compiled rules that were either registered with
+  // RegisterBinaryRules, or handed out by GetBinaryRules and are still
+  // cached. ICU doesn't validate compiled rules, so data from anywhere else
+  // is never parsed, and NULL is returned.
+  static BreakIteratorPool* GetForBinaryRules(const uint8_t* data,
+                                              int32_t length);
+
+  // Loads compiled rules the embedder trusts, so GetForBinaryRules accepts
+  // them in every isolate. Rules are loaded once per process, and kept as
+  // long as it runs. Has to be called before isolates run extension code on
+  // other threads. Returns false if ICU can't load the rules.
+  static bool RegisterBinaryRules(const uint8_t* data, size_t length);
+
+  // Returns compiled rules of the pool's iterators, owned by the pool, and
+  // remembers them so GetForBinaryRules accepts them.
+  const uint8_t* GetBinaryRules(uint32_t* length);
+
+  void AddReference();
+
+  // Drops a reference to the pool, deleting it if it was the last.
+  static void Unreference(BreakIteratorPool* pool);
+
+  // Sets maximum number of released iterators kept in each pool.
+  // Zero disables reuse.
+  static void SetLimit(int32_t limit);
+
+  // Returns a recycled iterator or a new clone of the prototype.
+  // Returns NULL if cloning fails.
+  icu::BreakIterator* Acquire();
+
+  // Takes ownership of an iterator acquired from this pool. It's either
+  // kept for reuse or deleted. Caller must not use the iterator's text
+  // after the release.
+  void Release(icu::BreakIterator* break_iterator);
+
+  // Sets maximum number of segmentations cached in each pool.
+  // Zero (the default) disables the cache.
+  static void SetCacheSize(int32_t size);
+
+  // Returns segmentation of the text |break_iterator| was just set to,
+  // either from the cache or by walking the iterator. The caller gets a
+  // reference, and has to drop it with Unreference.
+  // Returns NULL if the cache is disabled or the text is too long to cache.
+  Segmentation* Segment(const icu::UnicodeString& text,
+                        icu::BreakIterator* break_iterator);
+
+  // Drops a reference to the segmentation, deleting it if it was the last.
+  static void Unreference(Segmentation* segmentation);
+
+  Type type() const { return type_; }
+  int32_t cache_hits() const { return cache_hits_; }
+  int32_t cache_misses() const { return cache_misses_; }
+
+ private:
+  typedef std::list<Segmentation*> SegmentationList;
+  typedef std::map<int32_t, SegmentationList::iterator> SegmentationMap;
+
+  BreakIteratorPool(icu::BreakIterator* prototype, Type type);
+  ~BreakIteratorPool();
+
+  icu::BreakIterator* prototype_;
+  Type type_;
+  int32_t references_;
+  std::vector<icu::BreakIterator*> released_;
+
+  // Cached segmentations, most recently used first, and their index by
+  // text hash.
+  SegmentationList lru_;
+  SegmentationMap cache_;
+  int32_t cache_hits_;
+  int32_t cache_misses_;
+
+  static int32_t limit_;
+  static int32_t cache_size_;
+};
+
+}  // namespace v8_i18n
+
+#endif  // V8_I18N_SRC_BREAK_ITERATOR_POOL_H_
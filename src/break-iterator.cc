@@ -16,34 +16,101 @@
 
 #include <string.h>
 
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "src/break-iterator-pool.h"
+#include "src/property-names.h"
 #include "src/utils.h"
 #include "unicode/brkiter.h"
 #include "unicode/locid.h"
 #include "unicode/rbbi.h"
+#include "unicode/uchar.h"
+#include "unicode/utf16.h"
 
 namespace v8_i18n {
 
+// Categories of rule statuses of the word break iterator.
+// Keep values in sync with BREAK_TYPES in globals.js.
+enum BreakType {
+  BREAK_TYPE_NONE = 0,
+  BREAK_TYPE_NUMBER,
+  BREAK_TYPE_LETTER,
+  BREAK_TYPE_KANA,
+  BREAK_TYPE_IDEO,
+  BREAK_TYPE_UNKNOWN
+};
+
+static const char* const kBreakTypeNames[] = {
+  "none", "number", "letter", "kana", "ideo", "unknown"
+};
+
+// Part of the text segmented on its own, possibly on a worker thread.
+// Parts start and end at hard breaks, so the result is the same as if the
+// whole text was segmented at once.
+struct SegmentationTask {
+  icu::BreakIterator* break_iterator;
+  const UChar* text;
+  int32_t start;
+  int32_t end;
+  bool with_types;
+  std::vector<int32_t> positions;
+  std::vector<uint8_t> types;
+};
+
+// Position of an iterator within the cached segmentation of its text.
+// Iterators with a cached segmentation don't walk ICU iterator at all.
+struct SegmentationCursor {
+  Segmentation* segmentation;
+  int32_t index;
+};
+
 static v8::Handle<v8::Value> ThrowUnexpectedObjectError();
+static void ThrowRuleSyntaxError(const UParseError&);
+static BreakType GetBreakType(icu::BreakIterator*);
+static BreakType GetBreakTypeFromStatus(int32_t);
+static SegmentationCursor* GetCachedSegmentation(v8::Handle<v8::Object>);
+static void ResetCachedSegmentation(v8::Handle<v8::Object>, Segmentation*);
+static void RunSegmentationTask(SegmentationTask*);
+static void RunSegmentationTasks(std::vector<SegmentationTask>*);
 static icu::UnicodeString* ResetAdoptedText(v8::Handle<v8::Object>,
 					    v8::Handle<v8::Value>);
+static icu::UnicodeString* AppendStreamText(v8::Handle<v8::Object>,
+                                            v8::Handle<v8::Value>);
+static bool IsHardBreak(const UChar*, int32_t, int32_t);
+static int32_t FindLastHardBreak(const icu::UnicodeString&);
+static int32_t FindNextHardBreak(const UChar*, int32_t, int32_t);
+static bool IsStreamSyncPoint(icu::BreakIterator*, icu::BreakIterator*,
+                              const icu::UnicodeString&, int32_t);
+static int32_t FindStreamSyncPoint(icu::BreakIterator*,
+                                   icu::BreakIterator*,
+                                   const icu::UnicodeString&);
+static int32_t AdvanceSegments(v8::Handle<v8::Object>, icu::BreakIterator*,
+                               int32_t, int32_t*);
+static int32_t AdvanceGraphemes(icu::BreakIterator*, const UChar*, int32_t,
+                                int32_t, int32_t*);
+static int32_t FindLatin1RunEnd(const UChar*, int32_t, int32_t);
+static void MeasureSegment(const UChar*, int32_t, int32_t, bool,
+                           int32_t*, int32_t*);
 static icu::BreakIterator* InitializeBreakIterator(v8::Handle<v8::String>,
 						   v8::Handle<v8::Object>,
-						   v8::Handle<v8::Object>);
+						   v8::Handle<v8::Object>,
+						   BreakIteratorPool**);
 static icu::BreakIterator* CreateICUBreakIterator(const icu::Locale&,
-						  v8::Handle<v8::Object>);
+						  v8::Handle<v8::Object>,
+						  BreakIteratorPool**);
 static void SetResolvedSettings(const icu::Locale&,
                                 icu::BreakIterator*,
                                 v8::Handle<v8::Object>);
 
 icu::BreakIterator* BreakIterator::UnpackBreakIterator(
     v8::Handle<v8::Object> obj) {
-  v8::HandleScope handle_scope;
-
-  // v8::ObjectTemplate doesn't have HasInstance method so we can't check
-  // if obj is an instance of BreakIterator class. We'll check for a property
-  // that has to be in the object. The same applies to other services, like
-  // Collator and DateTimeFormat.
-  if (obj->HasOwnProperty(v8::String::New("breakIterator"))) {
+  if (Utils::HasWrapperType(obj, Utils::BREAK_ITERATOR_WRAPPER)) {
     return static_cast<icu::BreakIterator*>(
         obj->GetAlignedPointerFromInternalField(0));
   }
@@ -60,10 +127,21 @@ void BreakIterator::DeleteBreakIterator(v8::Isolate* isolate,
   // pointing to a break iterator.
   v8::HandleScope handle_scope(isolate);
   v8::Local<v8::Object> handle = v8::Local<v8::Object>::New(isolate, *object);
-  delete UnpackBreakIterator(handle);
+
+  // Give the iterator back to its pool, it may be handed out again.
+  BreakIteratorPool* pool = static_cast<BreakIteratorPool*>(
+      handle->GetAlignedPointerFromInternalField(2));
+  pool->Release(UnpackBreakIterator(handle));
+  BreakIteratorPool::Unreference(pool);
+
+  ResetCachedSegmentation(handle, NULL);
+  delete static_cast<SegmentationCursor*>(
+      handle->GetAlignedPointerFromInternalField(3));
 
   delete static_cast<icu::UnicodeString*>(
       handle->GetAlignedPointerFromInternalField(1));
+  delete static_cast<icu::UnicodeString*>(
+      handle->GetAlignedPointerFromInternalField(4));
 
   // Then dispose of the persistent handle to JS object.
   object->Dispose(isolate);
@@ -77,25 +155,210 @@ static v8::Handle<v8::Value> ThrowUnexpectedObjectError() {
                       "that is not a BreakIterator.")));
 }
 
-// Deletes the old value and sets the adopted text in corresponding
-// JavaScript object.
+// Throws a SyntaxError with the position of the rule that didn't compile.
+static void ThrowRuleSyntaxError(const UParseError& parse_error) {
+  v8::Local<v8::String> message = v8::String::Concat(
+      v8::String::New("Invalid v8Rules at line "),
+      v8::Integer::New(parse_error.line)->ToString());
+  message = v8::String::Concat(message, v8::String::New(", offset "));
+  message = v8::String::Concat(
+      message, v8::Integer::New(parse_error.offset)->ToString());
+  message = v8::String::Concat(message, v8::String::New("."));
+  v8::ThrowException(v8::Exception::SyntaxError(message));
+}
+
+// Returns the cursor if the object has a cached segmentation of its text,
+// NULL otherwise.
+static SegmentationCursor* GetCachedSegmentation(v8::Handle<v8::Object> obj) {
+  SegmentationCursor* cursor = static_cast<SegmentationCursor*>(
+      obj->GetAlignedPointerFromInternalField(3));
+  return cursor->segmentation ? cursor : NULL;
+}
+
+// Replaces the cached segmentation of the object's text, taking over the
+// reference to the new one. NULL means there is no cached segmentation.
+static void ResetCachedSegmentation(v8::Handle<v8::Object> obj,
+                                    Segmentation* segmentation) {
+  SegmentationCursor* cursor = static_cast<SegmentationCursor*>(
+      obj->GetAlignedPointerFromInternalField(3));
+  if (cursor->segmentation) {
+    BreakIteratorPool::Unreference(cursor->segmentation);
+  }
+  cursor->segmentation = segmentation;
+  cursor->index = 0;
+}
+
+// Copies the text into the buffer held by the corresponding JavaScript
+// object. The buffer is reused between calls, and is reallocated only if
+// it's too small or much larger than needed.
+// Returns NULL if the buffer couldn't be allocated, in which case the text
+// held by the object is empty.
 icu::UnicodeString* ResetAdoptedText(
     v8::Handle<v8::Object> obj, v8::Handle<v8::Value> value) {
+  // Buffers above this capacity get released if new text is a lot shorter,
+  // so a single large document doesn't pin its memory for the iterator's
+  // lifetime.
+  static const int32_t kMaxRetainedCapacity = 64 * 1024;
+
+  v8::Local<v8::String> string = value->ToString();
+  int32_t length = string->Length();
+
   // Get the previous value from the internal field.
   icu::UnicodeString* text = static_cast<icu::UnicodeString*>(
       obj->GetAlignedPointerFromInternalField(1));
-  delete text;
+  if (text && text->getCapacity() > kMaxRetainedCapacity &&
+      length < text->getCapacity() / 4) {
+    delete text;
+    text = NULL;
+  }
+
+  if (!text) {
+    text = new icu::UnicodeString();
+    obj->SetAlignedPointerInInternalField(1, text);
+  }
 
-  // Assign new value to the internal pointer.
-  v8::String::Value text_value(value);
-  text = new icu::UnicodeString(
-      reinterpret_cast<const UChar*>(*text_value), text_value.length());
-  obj->SetAlignedPointerInInternalField(1, text);
+  // Write V8 string directly into the ICU buffer. This avoids temporary
+  // copy String::Value makes, and allocation if the capacity suffices.
+  UChar* buffer = text->getBuffer(length);
+  if (!buffer) {
+    // Leave empty text behind, old buffer may be gone already.
+    text->remove();
+    return NULL;
+  }
+  string->Write(reinterpret_cast<uint16_t*>(buffer), 0, length,
+                v8::String::NO_NULL_TERMINATION);
+  text->releaseBuffer(length);
 
-  // Return new unicode string pointer.
   return text;
 }
 
+// Appends the text to the stream buffer held by the corresponding JavaScript
+// object. The stream has a buffer of its own, so the adopted text is left
+// alone.
+// Returns NULL if the buffer couldn't be allocated, in which case the stream
+// buffer is empty.
+icu::UnicodeString* AppendStreamText(
+    v8::Handle<v8::Object> obj, v8::Handle<v8::Value> value) {
+  v8::Local<v8::String> string = value->ToString();
+  int32_t length = string->Length();
+
+  icu::UnicodeString* text = static_cast<icu::UnicodeString*>(
+      obj->GetAlignedPointerFromInternalField(4));
+  if (!text) {
+    text = new icu::UnicodeString();
+    obj->SetAlignedPointerInInternalField(4, text);
+  }
+
+  int32_t old_length = text->length();
+  UChar* buffer = text->getBuffer(old_length + length);
+  if (!buffer) {
+    text->remove();
+    return NULL;
+  }
+  string->Write(reinterpret_cast<uint16_t*>(buffer + old_length), 0, length,
+                v8::String::NO_NULL_TERMINATION);
+  text->releaseBuffer(old_length + length);
+
+  return text;
+}
+
+// Returns true if |position| is right after a line or paragraph separator.
+// Iterators with built-in rules always break there, no matter what the
+// surrounding text is; custom rules may not. CR at the very end doesn't
+// count, since more text may start with LF.
+static bool IsHardBreak(const UChar* text, int32_t position, int32_t length) {
+  if (position <= 0 || position > length) {
+    return false;
+  }
+
+  switch (text[position - 1]) {
+    case 0x000A:  // LF
+    case 0x0085:  // NEL
+    case 0x2028:  // LS
+    case 0x2029:  // PS
+      return true;
+    case 0x000D:  // CR
+      return position < length && text[position] != 0x000A;
+  }
+  return false;
+}
+
+// Returns the last hard break position in the text, or 0 if there is none.
+static int32_t FindLastHardBreak(const icu::UnicodeString& text) {
+  const UChar* buffer = text.getBuffer();
+  for (int32_t i = text.length(); i > 0; --i) {
+    if (IsHardBreak(buffer, i, text.length())) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+// Returns the first hard break position after |start|, or |length| if there
+// is none.
+static int32_t FindNextHardBreak(const UChar* text,
+                                 int32_t start,
+                                 int32_t length) {
+  for (int32_t i = start + 1; i < length; ++i) {
+    if (IsHardBreak(text, i, length)) {
+      return i;
+    }
+  }
+  return length;
+}
+
+// Returns true if segmenting the text from |candidate| on with |checker|
+// gives the same boundaries |break_iterator| finds after |candidate|.
+static bool IsStreamSyncPoint(icu::BreakIterator* break_iterator,
+                              icu::BreakIterator* checker,
+                              const icu::UnicodeString& text,
+                              int32_t candidate) {
+  icu::UnicodeString tail(
+      FALSE, text.getBuffer() + candidate, text.length() - candidate);
+  checker->setText(tail);
+
+  int32_t expected = break_iterator->following(candidate);
+  int32_t actual = checker->first();
+  for (actual = checker->next();
+       expected != icu::BreakIterator::DONE &&
+       actual != icu::BreakIterator::DONE;
+       expected = break_iterator->next(), actual = checker->next()) {
+    if (expected != candidate + actual) {
+      return false;
+    }
+  }
+  return expected == actual;
+}
+
+// Returns a boundary, well before the end of the text, where segmentation
+// can start over without changing the boundaries that follow, or 0 if the
+// last few candidates don't qualify. |break_iterator| has to be set to
+// |text|.
+static int32_t FindStreamSyncPoint(icu::BreakIterator* break_iterator,
+                                   icu::BreakIterator* checker,
+                                   const icu::UnicodeString& text) {
+  // Text near the end may still change its boundaries as more arrives.
+  static const int32_t kStreamMargin = 256;
+  static const int kMaxCandidates = 8;
+
+  if (text.length() <= kStreamMargin) {
+    return 0;
+  }
+
+  int32_t candidate =
+      break_iterator->preceding(text.length() - kStreamMargin + 1);
+  for (int i = 0;
+       i < kMaxCandidates &&
+       candidate != icu::BreakIterator::DONE && candidate > 0;
+       ++i) {
+    if (IsStreamSyncPoint(break_iterator, checker, text, candidate)) {
+      return candidate;
+    }
+    candidate = break_iterator->preceding(candidate);
+  }
+  return 0;
+}
+
 void BreakIterator::JSInternalBreakIteratorAdoptText(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
   if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsString()) {
@@ -111,7 +374,35 @@ void BreakIterator::JSInternalBreakIteratorAdoptText(
     return;
   }
 
-  break_iterator->setText(*ResetAdoptedText(args[0]->ToObject(), args[1]));
+  // Old segmentation doesn't apply to the new text, and adopting text
+  // discards the stream.
+  ResetCachedSegmentation(args[0]->ToObject(), NULL);
+  icu::UnicodeString* stream = static_cast<icu::UnicodeString*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(4));
+  if (stream) {
+    stream->remove();
+  }
+
+  icu::UnicodeString* text = ResetAdoptedText(args[0]->ToObject(), args[1]);
+  if (!text) {
+    // Don't leave the iterator pointing to a released buffer.
+    break_iterator->setText(*static_cast<icu::UnicodeString*>(
+        args[0]->ToObject()->GetAlignedPointerFromInternalField(1)));
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New("Internal error. Couldn't allocate text buffer.")));
+    return;
+  }
+
+  // Iterator doesn't copy the text, it only references our buffer.
+  // It has to be reset even if the buffer didn't move, since the contents
+  // changed.
+  break_iterator->setText(*text);
+
+  // Short texts that were seen before reuse the boundaries found then.
+  BreakIteratorPool* pool = static_cast<BreakIteratorPool*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(2));
+  ResetCachedSegmentation(args[0]->ToObject(),
+                          pool->Segment(*text, break_iterator));
 }
 
 void BreakIterator::JSInternalBreakIteratorFirst(
@@ -122,6 +413,13 @@ void BreakIterator::JSInternalBreakIteratorFirst(
     return;
   }
 
+  SegmentationCursor* cursor = GetCachedSegmentation(args[0]->ToObject());
+  if (cursor) {
+    cursor->index = 0;
+    args.GetReturnValue().Set(cursor->segmentation->positions[0]);
+    return;
+  }
+
   args.GetReturnValue().Set(static_cast<int32_t>(break_iterator->first()));
 }
 
@@ -133,6 +431,22 @@ void BreakIterator::JSInternalBreakIteratorNext(
     return;
   }
 
+  SegmentationCursor* cursor = GetCachedSegmentation(args[0]->ToObject());
+  if (cursor) {
+    // Like ICU, stay at the last boundary once the end is reached.
+    int32_t count =
+        static_cast<int32_t>(cursor->segmentation->positions.size());
+    if (cursor->index + 1 >= count) {
+      args.GetReturnValue().Set(
+          static_cast<int32_t>(icu::BreakIterator::DONE));
+      return;
+    }
+    ++cursor->index;
+    args.GetReturnValue().Set(
+        cursor->segmentation->positions[cursor->index]);
+    return;
+  }
+
   args.GetReturnValue().Set(static_cast<int32_t>(break_iterator->next()));
 }
 
@@ -144,6 +458,13 @@ void BreakIterator::JSInternalBreakIteratorCurrent(
     return;
   }
 
+  SegmentationCursor* cursor = GetCachedSegmentation(args[0]->ToObject());
+  if (cursor) {
+    args.GetReturnValue().Set(
+        cursor->segmentation->positions[cursor->index]);
+    return;
+  }
+
   args.GetReturnValue().Set(static_cast<int32_t>(break_iterator->current()));
 }
 
@@ -155,26 +476,735 @@ void BreakIterator::JSInternalBreakIteratorBreakType(
     return;
   }
 
+  SegmentationCursor* cursor = GetCachedSegmentation(args[0]->ToObject());
+  if (cursor) {
+    args.GetReturnValue().Set(v8::String::New(kBreakTypeNames[
+        GetBreakTypeFromStatus(cursor->segmentation->statuses[cursor->index])]));
+    return;
+  }
+
+  args.GetReturnValue().Set(
+      v8::String::New(kBreakTypeNames[GetBreakType(break_iterator)]));
+}
+
+void BreakIterator::JSInternalBreakIteratorBoundaries(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  if (args.Length() != 3 || !args[0]->IsObject() || !args[1]->IsBoolean() ||
+      !args[2]->IsNumber()) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New(
+            "Internal error. Iterator, types flag and thread count have to "
+            "be specified.")));
+    return;
+  }
+
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  bool with_types = args[1]->BooleanValue();
+  int32_t threads = args[2]->Int32Value();
+
+  // Parallel segmentation doesn't pay off for short texts.
+  static const int32_t kMinParallelLength = 64 * 1024;
+  static const int32_t kMaxThreads = 16;
+
+  icu::UnicodeString* text = static_cast<icu::UnicodeString*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(1));
+  int32_t length = text ? text->length() : 0;
+
+  // Custom rules may not break at hard breaks, so splitting the text there
+  // could add boundaries. Such iterators are always segmented sequentially.
+  BreakIteratorPool* pool = static_cast<BreakIteratorPool*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(2));
+  if (pool->type() == BreakIteratorPool::CUSTOM) {
+    threads = 1;
+  }
+
+  std::vector<int32_t> positions;
+  std::vector<uint8_t> types;
+  SegmentationCursor* cursor = GetCachedSegmentation(args[0]->ToObject());
+  if (cursor) {
+    positions = cursor->segmentation->positions;
+    if (with_types) {
+      const std::vector<int32_t>& statuses = cursor->segmentation->statuses;
+      for (size_t i = 0; i < statuses.size(); ++i) {
+        types.push_back(
+            static_cast<uint8_t>(GetBreakTypeFromStatus(statuses[i])));
+      }
+    }
+  } else if (threads <= 1 || length < kMinParallelLength) {
+    // Restore the position at the end, so the walk is invisible to the user.
+    int32_t saved_position = break_iterator->current();
+
+    for (int32_t position = break_iterator->first();
+         position != icu::BreakIterator::DONE;
+         position = break_iterator->next()) {
+      positions.push_back(position);
+      if (with_types) {
+        types.push_back(static_cast<uint8_t>(GetBreakType(break_iterator)));
+      }
+    }
+
+    break_iterator->isBoundary(saved_position);
+  } else {
+    if (threads > kMaxThreads) {
+      threads = kMaxThreads;
+    }
+
+    // Split the text into parts of about the same size at hard breaks.
+    const UChar* buffer = text->getBuffer();
+    std::vector<int32_t> splits;
+    splits.push_back(0);
+    for (int32_t i = 1; i < threads; ++i) {
+      int32_t target = static_cast<int32_t>(
+          static_cast<int64_t>(length) * i / threads);
+      int32_t split = FindNextHardBreak(
+          buffer, target > splits.back() ? target - 1 : splits.back(), length);
+      if (split >= length) {
+        break;
+      }
+      splits.push_back(split);
+    }
+    splits.push_back(length);
+
+    std::vector<SegmentationTask> tasks(splits.size() - 1);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      tasks[i].break_iterator = pool->Acquire();
+      tasks[i].text = buffer;
+      tasks[i].start = splits[i];
+      tasks[i].end = splits[i + 1];
+      tasks[i].with_types = with_types;
+    }
+
+    RunSegmentationTasks(&tasks);
+
+    // Merge results. Each part but the first skips its start, which is
+    // the end of the previous part.
+    bool failed = false;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      if (!tasks[i].break_iterator) {
+        failed = true;
+        continue;
+      }
+      pool->Release(tasks[i].break_iterator);
+      positions.insert(positions.end(), tasks[i].positions.begin(),
+                       tasks[i].positions.end());
+      types.insert(types.end(), tasks[i].types.begin(), tasks[i].types.end());
+    }
+
+    if (failed) {
+      v8::ThrowException(v8::Exception::Error(v8::String::New(
+          "Internal error. Couldn't create ICU break iterator.")));
+      return;
+    }
+  }
+
+  int32_t count = static_cast<int32_t>(positions.size());
+  v8::Local<v8::Int32Array> boundaries =
+      Utils::NewInt32Array(count ? &positions[0] : NULL, count);
+  if (!with_types) {
+    args.GetReturnValue().Set(boundaries);
+    return;
+  }
+
+  v8::Local<v8::Array> result = v8::Array::New(2);
+  result->Set(0, boundaries);
+  result->Set(1, Utils::NewUint8Array(count ? &types[0] : NULL, count));
+  args.GetReturnValue().Set(result);
+}
+
+// Segments a part of the text with the task's own iterator.
+static void RunSegmentationTask(SegmentationTask* task) {
+  // Read-only alias, the text is not copied.
+  icu::UnicodeString part(FALSE, task->text + task->start,
+                          task->end - task->start);
+  task->break_iterator->setText(part);
+
+  for (int32_t position = task->break_iterator->first();
+       position != icu::BreakIterator::DONE;
+       position = task->break_iterator->next()) {
+    if (position == 0 && task->start != 0) {
+      continue;
+    }
+    task->positions.push_back(task->start + position);
+    if (task->with_types) {
+      task->types.push_back(
+          static_cast<uint8_t>(GetBreakType(task->break_iterator)));
+    }
+  }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI SegmentationThreadMain(LPVOID task) {
+  RunSegmentationTask(static_cast<SegmentationTask*>(task));
+  return 0;
+}
+#else
+static void* SegmentationThreadMain(void* task) {
+  RunSegmentationTask(static_cast<SegmentationTask*>(task));
+  return NULL;
+}
+#endif
+
+// Runs the first task on this thread and the rest on worker threads, and
+// waits for all of them. Tasks without an iterator are skipped. If a thread
+// can't be started its task runs on this thread.
+// Worker threads only touch ICU objects and buffers owned by the tasks,
+// never V8.
+static void RunSegmentationTasks(std::vector<SegmentationTask>* tasks) {
+#if defined(_WIN32)
+  std::vector<HANDLE> threads(tasks->size(), static_cast<HANDLE>(NULL));
+#else
+  std::vector<pthread_t> threads(tasks->size());
+  std::vector<bool> started(tasks->size(), false);
+#endif
+
+  for (size_t i = 1; i < tasks->size(); ++i) {
+    SegmentationTask* task = &(*tasks)[i];
+    if (!task->break_iterator) {
+      continue;
+    }
+#if defined(_WIN32)
+    threads[i] = CreateThread(NULL, 0, &SegmentationThreadMain, task, 0, NULL);
+    if (!threads[i]) {
+      RunSegmentationTask(task);
+    }
+#else
+    started[i] =
+        pthread_create(&threads[i], NULL, &SegmentationThreadMain, task) == 0;
+    if (!started[i]) {
+      RunSegmentationTask(task);
+    }
+#endif
+  }
+
+  if ((*tasks)[0].break_iterator) {
+    RunSegmentationTask(&(*tasks)[0]);
+  }
+
+  for (size_t i = 1; i < tasks->size(); ++i) {
+#if defined(_WIN32)
+    if (threads[i]) {
+      WaitForSingleObject(threads[i], INFINITE);
+      CloseHandle(threads[i]);
+    }
+#else
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    }
+#endif
+  }
+}
+
+void BreakIterator::JSInternalBreakIteratorTokens(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsBoolean()) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New(
+            "Internal error. Iterator and filter flag have to be specified.")));
+    return;
+  }
+
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  bool include_none = args[1]->BooleanValue();
+
+  v8::Local<v8::Array> tokens = v8::Array::New();
+  v8::Local<v8::Array> types = v8::Array::New();
+  v8::Local<v8::Array> result = v8::Array::New(2);
+  result->Set(0, tokens);
+  result->Set(1, types);
+
+  icu::UnicodeString* text = static_cast<icu::UnicodeString*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(1));
+  if (!text) {
+    // Nothing was adopted yet.
+    args.GetReturnValue().Set(result);
+    return;
+  }
+
+  // Create type names once, not per token.
+  v8::Local<v8::String> type_names[BREAK_TYPE_UNKNOWN + 1];
+  for (int i = 0; i <= BREAK_TYPE_UNKNOWN; ++i) {
+    type_names[i] = v8::String::New(kBreakTypeNames[i]);
+  }
+
+  // Restore the position at the end, so the walk is invisible to the user.
+  int32_t saved_position = break_iterator->current();
+
+  const uint16_t* buffer = reinterpret_cast<const uint16_t*>(text->getBuffer());
+  uint32_t count = 0;
+  int32_t start = break_iterator->first();
+  for (int32_t end = break_iterator->next();
+       end != icu::BreakIterator::DONE;
+       start = end, end = break_iterator->next()) {
+    BreakType type = GetBreakType(break_iterator);
+    if (type == BREAK_TYPE_NONE && !include_none) {
+      continue;
+    }
+    tokens->Set(count, v8::String::New(buffer + start, end - start));
+    types->Set(count, type_names[type]);
+    ++count;
+  }
+
+  break_iterator->isBoundary(saved_position);
+
+  args.GetReturnValue().Set(result);
+}
+
+void BreakIterator::JSInternalBreakIteratorSegmentChunk(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  // Longest unsettled tail we keep without a hard break in it. Past this
+  // point we settle at a boundary where segmentation starts over cleanly,
+  // which may rarely give different results than segmenting the whole text
+  // at once.
+  static const int32_t kMaxStreamTail = 64 * 1024;
+
+  if (args.Length() != 5 || !args[0]->IsObject() || !args[1]->IsString() ||
+      !args[2]->IsNumber() || !args[3]->IsBoolean() || !args[4]->IsBoolean()) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New(
+            "Internal error. Iterator, chunk and stream state have to be "
+            "specified.")));
+    return;
+  }
+
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  int32_t offset = args[2]->Int32Value();
+  bool include_start = args[3]->BooleanValue();
+  bool is_last = args[4]->BooleanValue();
+
+  // The iterator walks the stream buffer for a while, and goes back to the
+  // adopted text, at the same position, when done.
+  v8::Local<v8::Object> obj = args[0]->ToObject();
+  icu::UnicodeString* adopted = static_cast<icu::UnicodeString*>(
+      obj->GetAlignedPointerFromInternalField(1));
+  if (!adopted) {
+    adopted = new icu::UnicodeString();
+    obj->SetAlignedPointerInInternalField(1, adopted);
+  }
+  int32_t saved_position = break_iterator->current();
+
+  // Stream buffer holds the unsettled tail of the previous chunk, unless
+  // this is the start of a new stream.
+  icu::UnicodeString* stream = static_cast<icu::UnicodeString*>(
+      obj->GetAlignedPointerFromInternalField(4));
+  if (stream && include_start) {
+    stream->remove();
+  }
+  icu::UnicodeString* text = AppendStreamText(obj, args[1]);
+  if (!text) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New("Internal error. Couldn't allocate text buffer.")));
+    return;
+  }
+  break_iterator->setText(*text);
+
+  // Text always starts where the previous chunk settled (or at the start of
+  // the stream). Built-in rules always break at hard breaks, so boundaries
+  // up to the last one don't depend on the text that follows it. Custom
+  // rules may not break there, so they only settle at sync points.
+  BreakIteratorPool* pool = static_cast<BreakIteratorPool*>(
+      obj->GetAlignedPointerFromInternalField(2));
+  int32_t settled = text->length();
+  if (!is_last) {
+    settled = 0;
+    if (pool->type() != BreakIteratorPool::CUSTOM) {
+      int32_t hard_break = FindLastHardBreak(*text);
+      if (hard_break > 0 && break_iterator->isBoundary(hard_break)) {
+        settled = hard_break;
+      }
+    }
+    if (settled == 0 && text->length() > kMaxStreamTail) {
+      icu::BreakIterator* checker = pool->Acquire();
+      if (checker) {
+        settled = FindStreamSyncPoint(break_iterator, checker, *text);
+        pool->Release(checker);
+      }
+    }
+  }
+
+  std::vector<int32_t> positions;
+  for (int32_t position = break_iterator->first();
+       position != icu::BreakIterator::DONE && position <= settled;
+       position = break_iterator->next()) {
+    if (position != 0 || include_start) {
+      positions.push_back(offset + position);
+    }
+  }
+
+  // Keep only the unsettled tail for the next chunk.
+  text->remove(0, settled);
+
+  break_iterator->setText(*adopted);
+  break_iterator->isBoundary(saved_position);
+
+  int32_t count = static_cast<int32_t>(positions.size());
+  v8::Local<v8::Array> result = v8::Array::New(2);
+  result->Set(0, Utils::NewInt32Array(count ? &positions[0] : NULL, count));
+  result->Set(1, v8::Integer::New(offset + settled));
+  args.GetReturnValue().Set(result);
+}
+
+void BreakIterator::JSInternalBreakIteratorBinaryRules(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  BreakIteratorPool* pool = static_cast<BreakIteratorPool*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(2));
+  uint32_t length = 0;
+  const uint8_t* data = pool->GetBinaryRules(&length);
+
+  args.GetReturnValue().Set(
+      Utils::NewUint8Array(data, static_cast<int32_t>(length)));
+}
+
+void BreakIterator::JSInternalBreakIteratorCacheStats(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  BreakIteratorPool* pool = static_cast<BreakIteratorPool*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(2));
+
+  v8::Local<v8::Object> result = v8::Object::New();
+  result->Set(PropertyNames::Get(PropertyNames::HITS),
+              v8::Integer::New(pool->cache_hits()));
+  result->Set(PropertyNames::Get(PropertyNames::MISSES),
+              v8::Integer::New(pool->cache_misses()));
+  args.GetReturnValue().Set(result);
+}
+
+void BreakIterator::JSInternalBreakIteratorSegmentCount(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  int32_t count = 0;
+  AdvanceSegments(args[0]->ToObject(), break_iterator, INT32_MAX, &count);
+  args.GetReturnValue().Set(count);
+}
+
+void BreakIterator::JSInternalBreakIteratorSegmentOffset(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsNumber()) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New(
+            "Internal error. Iterator and count have to be specified.")));
+    return;
+  }
+
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  int32_t count = 0;
+  args.GetReturnValue().Set(AdvanceSegments(
+      args[0]->ToObject(), break_iterator, args[1]->Int32Value(), &count));
+}
+
+void BreakIterator::JSInternalBreakIteratorPrecedingBoundary(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsNumber()) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New(
+            "Internal error. Iterator and limit have to be specified.")));
+    return;
+  }
+
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  icu::UnicodeString* text = static_cast<icu::UnicodeString*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(1));
+  int32_t length = text ? text->length() : 0;
+  int32_t limit = args[1]->Int32Value();
+  if (limit >= length) {
+    args.GetReturnValue().Set(length);
+    return;
+  }
+  if (limit <= 0) {
+    args.GetReturnValue().Set(0);
+    return;
+  }
+
+  int32_t saved_position = break_iterator->current();
+  int32_t result = limit;
+  if (!break_iterator->isBoundary(limit)) {
+    result = break_iterator->preceding(limit);
+  }
+  break_iterator->isBoundary(saved_position);
+
+  args.GetReturnValue().Set(result);
+}
+
+void BreakIterator::JSInternalBreakIteratorWrap(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  if (args.Length() != 3 || !args[0]->IsObject() || !args[1]->IsNumber() ||
+      !args[2]->IsBoolean()) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New(
+            "Internal error. Iterator, width and mode have to be specified.")));
+    return;
+  }
+
+  icu::BreakIterator* break_iterator = UnpackBreakIterator(args[0]->ToObject());
+  if (!break_iterator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  int32_t width = args[1]->Int32Value();
+  bool columns = args[2]->BooleanValue();
+
+  std::vector<int32_t> breaks;
+  icu::UnicodeString* text = static_cast<icu::UnicodeString*>(
+      args[0]->ToObject()->GetAlignedPointerFromInternalField(1));
+  if (text) {
+    const UChar* buffer = text->getBuffer();
+    int32_t length = text->length();
+
+    // TODO(cira): Remove cast once ICU fixes base BreakIterator class.
+    icu::RuleBasedBreakIterator* rule_based_iterator =
+        static_cast<icu::RuleBasedBreakIterator*>(break_iterator);
+
+    int32_t saved_position = break_iterator->current();
+
+    // Greedy fill: put as many segments on a line as fit. Trailing white
+    // space of the last segment on a line doesn't count toward the width.
+    // Segments wider than the whole line overflow it.
+    int32_t line_start = 0;
+    int32_t line_width = 0;
+    int32_t start = break_iterator->first();
+    for (int32_t end = break_iterator->next();
+         end != icu::BreakIterator::DONE;
+         start = end, end = break_iterator->next()) {
+      int32_t segment_width = 0;
+      int32_t visible_width = 0;
+      MeasureSegment(buffer, start, end, columns,
+                     &segment_width, &visible_width);
+
+      if (start > line_start && line_width + visible_width > width) {
+        breaks.push_back(start);
+        line_start = start;
+        line_width = 0;
+      }
+      line_width += segment_width;
+
+      // Mandatory breaks (new lines) always end the line.
+      if (rule_based_iterator->getRuleStatus() >= UBRK_LINE_HARD &&
+          end < length) {
+        breaks.push_back(end);
+        line_start = end;
+        line_width = 0;
+      }
+    }
+
+    break_iterator->isBoundary(saved_position);
+  }
+
+  int32_t count = static_cast<int32_t>(breaks.size());
+  args.GetReturnValue().Set(
+      Utils::NewInt32Array(count ? &breaks[0] : NULL, count));
+}
+
+// Measures text between |start| and |end|, in code units or, if |columns|
+// is set, in terminal columns (East Asian wide and fullwidth characters
+// take two, combining marks and format characters none).
+// |visible_width| excludes trailing white space.
+static void MeasureSegment(const UChar* text,
+                           int32_t start,
+                           int32_t end,
+                           bool columns,
+                           int32_t* segment_width,
+                           int32_t* visible_width) {
+  int32_t width = 0;
+  int32_t trailing_space_width = 0;
+  int32_t i = start;
+  while (i < end) {
+    UChar32 c;
+    int32_t previous = i;
+    U16_NEXT(text, i, end, c);
+
+    int32_t char_width = i - previous;
+    if (columns) {
+      int8_t category = u_charType(c);
+      if (category == U_NON_SPACING_MARK || category == U_ENCLOSING_MARK ||
+          category == U_FORMAT_CHAR || category == U_CONTROL_CHAR) {
+        char_width = 0;
+      } else {
+        int32_t east_asian_width =
+            u_getIntPropertyValue(c, UCHAR_EAST_ASIAN_WIDTH);
+        char_width = (east_asian_width == U_EA_WIDE ||
+                      east_asian_width == U_EA_FULLWIDTH) ? 2 : 1;
+      }
+    }
+
+    width += char_width;
+    if (u_isUWhiteSpace(c)) {
+      trailing_space_width += char_width;
+    } else {
+      trailing_space_width = 0;
+    }
+  }
+
+  *segment_width = width;
+  *visible_width = width - trailing_space_width;
+}
+
+// Moves |n| segments forward from the start of the adopted text, or to the
+// end of it. Stores the number of segments passed in |count| and returns the
+// new position. Position of the iterator is not changed.
+static int32_t AdvanceSegments(v8::Handle<v8::Object> obj,
+                               icu::BreakIterator* break_iterator,
+                               int32_t n,
+                               int32_t* count) {
+  *count = 0;
+  icu::UnicodeString* text = static_cast<icu::UnicodeString*>(
+      obj->GetAlignedPointerFromInternalField(1));
+  if (!text || n <= 0) {
+    return 0;
+  }
+
+  int32_t saved_position = break_iterator->current();
+
+  int32_t position = 0;
+  BreakIteratorPool* pool = static_cast<BreakIteratorPool*>(
+      obj->GetAlignedPointerFromInternalField(2));
+  if (pool->type() == BreakIteratorPool::CHARACTER) {
+    position = AdvanceGraphemes(
+        break_iterator, text->getBuffer(), text->length(), n, count);
+  } else {
+    position = break_iterator->first();
+    while (*count < n) {
+      int32_t next = break_iterator->next();
+      if (next == icu::BreakIterator::DONE) {
+        break;
+      }
+      position = next;
+      ++*count;
+    }
+  }
+
+  break_iterator->isBoundary(saved_position);
+
+  return position;
+}
+
+// Moves |n| grapheme clusters forward from the start of the text, or to the
+// end of it. Runs of Latin-1 characters are handled without ICU, since each
+// character there is a cluster of its own, except for CR LF pairs.
+// Stores the number of clusters passed in |count| and returns the new
+// position.
+static int32_t AdvanceGraphemes(icu::BreakIterator* break_iterator,
+                                const UChar* text,
+                                int32_t length,
+                                int32_t n,
+                                int32_t* count) {
+  int32_t position = 0;
+  while (position < length && *count < n) {
+    int32_t run_end = FindLatin1RunEnd(text, position, length);
+
+    // The last Latin-1 character may combine with marks that follow it,
+    // so leave it to ICU, unless the run goes to the end of the text.
+    int32_t fast_end = (run_end == length) ? length : run_end - 1;
+    while (position < fast_end && *count < n) {
+      if (text[position] == 0x0D && position + 1 < length &&
+          text[position + 1] == 0x0A) {
+        position += 2;
+      } else {
+        ++position;
+      }
+      ++*count;
+    }
+
+    if (position < length && position >= fast_end && *count < n) {
+      position = break_iterator->following(position);
+      if (position == icu::BreakIterator::DONE) {
+        position = length;
+      }
+      ++*count;
+    }
+  }
+
+  return position;
+}
+
+// Returns the position of the first non Latin-1 character at or after
+// |start|, or |length| if there is none.
+static int32_t FindLatin1RunEnd(const UChar* text,
+                                int32_t start,
+                                int32_t length) {
+  // Check four characters at a time. Mask has high byte of each 16 bit
+  // lane set, so it works on both byte orders.
+  static const uint64_t kNonLatin1Mask = 0xFF00FF00FF00FF00ULL;
+
+  int32_t i = start;
+  for (; i + 4 <= length; i += 4) {
+    uint64_t chunk;
+    memcpy(&chunk, text + i, sizeof(chunk));
+    if (chunk & kNonLatin1Mask) {
+      break;
+    }
+  }
+
+  while (i < length && text[i] < 0x100) {
+    ++i;
+  }
+
+  return i;
+}
+
+// Maps rule status of the current break into one of the BreakType values.
+// This is only meaningful for word break iterators. Others return none.
+static BreakType GetBreakType(icu::BreakIterator* break_iterator) {
   // TODO(cira): Remove cast once ICU fixes base BreakIterator class.
   icu::RuleBasedBreakIterator* rule_based_iterator =
       static_cast<icu::RuleBasedBreakIterator*>(break_iterator);
-  int32_t status = rule_based_iterator->getRuleStatus();
-  // Keep return values in sync with JavaScript BreakType enum.
-  v8::Handle<v8::String> result;
+  return GetBreakTypeFromStatus(rule_based_iterator->getRuleStatus());
+}
+
+// Maps a rule status into one of the BreakType values.
+static BreakType GetBreakTypeFromStatus(int32_t status) {
   if (status >= UBRK_WORD_NONE && status < UBRK_WORD_NONE_LIMIT) {
-    result = v8::String::New("none");
+    return BREAK_TYPE_NONE;
   } else if (status >= UBRK_WORD_NUMBER && status < UBRK_WORD_NUMBER_LIMIT) {
-    result = v8::String::New("number");
+    return BREAK_TYPE_NUMBER;
   } else if (status >= UBRK_WORD_LETTER && status < UBRK_WORD_LETTER_LIMIT) {
-    result = v8::String::New("letter");
+    return BREAK_TYPE_LETTER;
   } else if (status >= UBRK_WORD_KANA && status < UBRK_WORD_KANA_LIMIT) {
-    result = v8::String::New("kana");
+    return BREAK_TYPE_KANA;
   } else if (status >= UBRK_WORD_IDEO && status < UBRK_WORD_IDEO_LIMIT) {
-    result = v8::String::New("ideo");
-  } else {
-    result = v8::String::New("unknown");
+    return BREAK_TYPE_IDEO;
   }
-  args.GetReturnValue().Set(result);
+  return BREAK_TYPE_UNKNOWN;
 }
 
 void BreakIterator::JSCreateBreakIterator(
@@ -188,7 +1218,7 @@ void BreakIterator::JSCreateBreakIterator(
 
   v8::Isolate* isolate = args.GetIsolate();
   v8::Local<v8::ObjectTemplate> break_iterator_template =
-      Utils::GetTemplate2(isolate);
+      Utils::GetTemplate5(isolate);
 
   // Create an empty object wrapper.
   v8::Local<v8::Object> local_object = break_iterator_template->NewInstance();
@@ -199,9 +1229,36 @@ void BreakIterator::JSCreateBreakIterator(
     return;
   }
 
+  // Compiled rules aren't validated by ICU, so only rules this isolate
+  // handed out, or the embedder registered, are accepted. Rule source is
+  // compiled here, to report where it's wrong.
+  v8::Local<v8::Value> binary_rules = args[1]->ToObject()->Get(
+      PropertyNames::Get(PropertyNames::BINARY_RULES));
+  icu::UnicodeString rules;
+  if (binary_rules->IsUint8Array()) {
+    v8::Local<v8::Object> array = binary_rules->ToObject();
+    if (!BreakIteratorPool::GetForBinaryRules(
+            static_cast<const uint8_t*>(
+                array->GetIndexedPropertiesExternalArrayData()),
+            array->GetIndexedPropertiesExternalArrayDataLength())) {
+      v8::ThrowException(v8::Exception::TypeError(v8::String::New(
+          "Unknown v8BinaryRules. Only rules returned by v8BinaryRules() "
+          "or registered by the embedder are accepted.")));
+      return;
+    }
+  } else if (Utils::ExtractStringSetting(args[1]->ToObject(),
+                                         PropertyNames::RULES, &rules)) {
+    UParseError parse_error;
+    if (!BreakIteratorPool::GetForRules(rules, &parse_error)) {
+      ThrowRuleSyntaxError(parse_error);
+      return;
+    }
+  }
+
   // Set break iterator as internal field of the resulting JS object.
+  BreakIteratorPool* pool = NULL;
   icu::BreakIterator* break_iterator = InitializeBreakIterator(
-      args[0]->ToString(), args[1]->ToObject(), args[2]->ToObject());
+      args[0]->ToString(), args[1]->ToObject(), args[2]->ToObject(), &pool);
 
   if (!break_iterator) {
     v8::ThrowException(v8::Exception::Error(v8::String::New(
@@ -211,14 +1268,16 @@ void BreakIterator::JSCreateBreakIterator(
     local_object->SetAlignedPointerInInternalField(0, break_iterator);
     // Make sure that the pointer to adopted text is NULL.
     local_object->SetAlignedPointerInInternalField(1, NULL);
+    local_object->SetAlignedPointerInInternalField(2, pool);
+    pool->AddReference();
+    SegmentationCursor* cursor = new SegmentationCursor();
+    cursor->segmentation = NULL;
+    cursor->index = 0;
+    local_object->SetAlignedPointerInInternalField(3, cursor);
+    // Stream buffer is created with the first chunk.
+    local_object->SetAlignedPointerInInternalField(4, NULL);
 
-    v8::TryCatch try_catch;
-    local_object->Set(v8::String::New("breakIterator"), v8::String::New("valid"));
-    if (try_catch.HasCaught()) {
-      v8::ThrowException(v8::Exception::Error(
-          v8::String::New("Internal error, couldn't set property.")));
-      return;
-    }
+    Utils::SetWrapperType(local_object, Utils::BREAK_ITERATOR_WRAPPER);
   }
 
   v8::Persistent<v8::Object> wrapper(isolate, local_object);
@@ -231,7 +1290,8 @@ void BreakIterator::JSCreateBreakIterator(
 static icu::BreakIterator* InitializeBreakIterator(
     v8::Handle<v8::String> locale,
     v8::Handle<v8::Object> options,
-    v8::Handle<v8::Object> resolved) {
+    v8::Handle<v8::Object> resolved,
+    BreakIteratorPool** pool) {
   // Convert BCP47 into ICU locale format.
   UErrorCode status = U_ZERO_ERROR;
   icu::Locale icu_locale;
@@ -248,11 +1308,12 @@ static icu::BreakIterator* InitializeBreakIterator(
   }
 
   icu::BreakIterator* break_iterator =
-    CreateICUBreakIterator(icu_locale, options);
+    CreateICUBreakIterator(icu_locale, options, pool);
   if (!break_iterator) {
     // Remove extensions and try again.
     icu::Locale no_extension_locale(icu_locale.getBaseName());
-    break_iterator = CreateICUBreakIterator(no_extension_locale, options);
+    break_iterator =
+      CreateICUBreakIterator(no_extension_locale, options, pool);
 
     // Set resolved settings (locale).
     SetResolvedSettings(no_extension_locale, break_iterator, resolved);
@@ -263,37 +1324,54 @@ static icu::BreakIterator* InitializeBreakIterator(
   return break_iterator;
 }
 
+// Clones the iterator from the pool for the locale and type, so rules and
+// dictionaries are loaded only once per locale. Custom rules, either
+// source or compiled, replace the locale's rules.
 static icu::BreakIterator* CreateICUBreakIterator(
-    const icu::Locale& icu_locale, v8::Handle<v8::Object> options) {
-  UErrorCode status = U_ZERO_ERROR;
-  icu::BreakIterator* break_iterator = NULL;
+    const icu::Locale& icu_locale,
+    v8::Handle<v8::Object> options,
+    BreakIteratorPool** pool) {
+  v8::Local<v8::Value> binary_rules =
+      options->Get(PropertyNames::Get(PropertyNames::BINARY_RULES));
+  if (binary_rules->IsUint8Array()) {
+    v8::Local<v8::Object> array = binary_rules->ToObject();
+    *pool = BreakIteratorPool::GetForBinaryRules(
+        static_cast<const uint8_t*>(
+            array->GetIndexedPropertiesExternalArrayData()),
+        array->GetIndexedPropertiesExternalArrayDataLength());
+    return *pool ? (*pool)->Acquire() : NULL;
+  }
+
+  icu::UnicodeString rules;
+  if (Utils::ExtractStringSetting(options, PropertyNames::RULES, &rules)) {
+    *pool = BreakIteratorPool::GetForRules(rules, NULL);
+    return *pool ? (*pool)->Acquire() : NULL;
+  }
+
   icu::UnicodeString type;
-  if (!Utils::ExtractStringSetting(options, "type", &type)) {
+  if (!Utils::ExtractStringSetting(options, PropertyNames::TYPE, &type)) {
     // Type had to be in the options. This would be an internal error.
     return NULL;
   }
 
+  BreakIteratorPool::Type pool_type;
   if (type == UNICODE_STRING_SIMPLE("character")) {
-    break_iterator =
-      icu::BreakIterator::createCharacterInstance(icu_locale, status);
+    pool_type = BreakIteratorPool::CHARACTER;
   } else if (type == UNICODE_STRING_SIMPLE("sentence")) {
-    break_iterator =
-      icu::BreakIterator::createSentenceInstance(icu_locale, status);
+    pool_type = BreakIteratorPool::SENTENCE;
   } else if (type == UNICODE_STRING_SIMPLE("line")) {
-    break_iterator =
-      icu::BreakIterator::createLineInstance(icu_locale, status);
+    pool_type = BreakIteratorPool::LINE;
   } else {
     // Defualt is word iterator.
-    break_iterator =
-      icu::BreakIterator::createWordInstance(icu_locale, status);
+    pool_type = BreakIteratorPool::WORD;
   }
 
-  if (U_FAILURE(status)) {
-    delete break_iterator;
+  *pool = BreakIteratorPool::Get(icu_locale, pool_type);
+  if (!*pool) {
     return NULL;
   }
 
-  return break_iterator;
+  return (*pool)->Acquire();
 }
 
 static void SetResolvedSettings(const icu::Locale& icu_locale,
@@ -307,10 +1385,12 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
   uloc_toLanguageTag(
       icu_locale.getName(), result, ULOC_FULLNAME_CAPACITY, FALSE, &status);
   if (U_SUCCESS(status)) {
-    resolved->Set(v8::String::New("locale"), v8::String::New(result));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New(result));
   } else {
     // This would never happen, since we got the locale from ICU.
-    resolved->Set(v8::String::New("locale"), v8::String::New("und"));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New("und"));
   }
 }
 
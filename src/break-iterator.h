@@ -36,7 +36,8 @@ class BreakIterator {
   static icu::BreakIterator* UnpackBreakIterator(v8::Handle<v8::Object> obj);
 
   // Release memory we allocated for the BreakIterator once the JS object that
-  // holds the pointer gets garbage collected.
+  // holds the pointer gets garbage collected. Iterator itself is returned to
+  // its pool.
   static void DeleteBreakIterator(v8::Isolate* isolate,
                                   v8::Persistent<v8::Object>* object,
 				  void* param);
@@ -62,6 +63,57 @@ class BreakIterator {
   static void JSInternalBreakIteratorBreakType(
       const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  // Walks the whole adopted text and returns all break positions as an
+  // Int32Array. If the second argument is true, returns an array with the
+  // positions and a parallel Uint8Array of break types (see BreakType).
+  // Third argument is the number of threads to use for long texts.
+  static void JSInternalBreakIteratorBoundaries(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Walks the whole adopted text and returns an array with two parallel
+  // arrays: segments of the text and their break types. Segments of type
+  // none are skipped unless the second argument is true.
+  static void JSInternalBreakIteratorTokens(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Returns the number of segments in the adopted text. Grapheme clusters
+  // of character iterators are counted without ICU for Latin-1 text.
+  static void JSInternalBreakIteratorSegmentCount(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Returns the position after the first N segments of the adopted text,
+  // or the text length if there are fewer.
+  static void JSInternalBreakIteratorSegmentOffset(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Returns the last boundary at or before given position.
+  static void JSInternalBreakIteratorPrecedingBoundary(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Wraps the adopted text into lines of a given width (in code units or
+  // terminal columns) at the iterator's boundaries, and returns an
+  // Int32Array of positions where new lines start.
+  static void JSInternalBreakIteratorWrap(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Appends a chunk of text to the unsettled tail of the stream and returns
+  // an Int32Array of boundaries (offset from the start of the stream) that
+  // can't change with more text. The rest is kept for the next chunk.
+  static void JSInternalBreakIteratorSegmentChunk(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Returns rules of the iterator in compiled form, as an Uint8Array.
+  // The result can be passed back as v8BinaryRules option in the same
+  // isolate, or registered by the embedder with
+  // Extension::RegisterBreakRules, which skips rule compilation.
+  static void JSInternalBreakIteratorBinaryRules(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Returns hits and misses of the segmentation cache shared by iterators
+  // of the same locale and type.
+  static void JSInternalBreakIteratorCacheStats(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
  private:
   BreakIterator() {}
 };
@@ -38,6 +38,26 @@ function initializeBreakIterator(iterator, locales, options) {
   defineWEProperty(internalOptions, 'type', getOption(
     'type', 'string', ['character', 'word', 'sentence', 'line'], 'word'));
 
+  // Custom rules replace the rules of the locale and type. Compiled rules,
+  // as returned by v8BinaryRules(), take precedence over rule source.
+  // Compiled rules from anywhere else, unless the embedder registered them,
+  // are rejected natively.
+  var binaryRules = options.v8BinaryRules;
+  if (binaryRules !== undefined) {
+    if (binaryRules instanceof ArrayBuffer) {
+      binaryRules = new Uint8Array(binaryRules);
+    } else if (!(binaryRules instanceof Uint8Array)) {
+      throw new TypeError('v8BinaryRules has to be an ArrayBuffer or ' +
+                          'an Uint8Array.');
+    }
+    defineWEProperty(internalOptions, 'binaryRules', binaryRules);
+  }
+
+  var rules = getOption('v8Rules', 'string');
+  if (rules !== undefined) {
+    defineWEProperty(internalOptions, 'rules', rules);
+  }
+
   var locale = resolveLocale('breakiterator', locales, options);
   var resolved = Object.defineProperties({}, {
     requestedLocale: {value: locale.locale, writable: true},
@@ -50,6 +70,8 @@ function initializeBreakIterator(iterator, locales, options) {
                                                      resolved);
 
   Object.defineProperty(iterator, 'iterator', {value: internalIterator});
+  Object.defineProperty(iterator, 'stream',
+                        {value: {offset: 0, started: false}});
   Object.defineProperty(iterator, 'resolved', {value: resolved});
   Object.defineProperty(iterator, '__initializedIntlObject',
                         {value: 'breakiterator'});
@@ -132,47 +154,211 @@ function initializeBreakIterator(iterator, locales, options) {
 function adoptText(iterator, text) {
   native function NativeJSBreakIteratorAdoptText();
   NativeJSBreakIteratorAdoptText(iterator.iterator, String(text));
+  resetStream(iterator);
+}
+
+
+/**
+ * Returns all break positions of the adopted text in an Int32Array, using a
+ * single native call. If withTypes is true, returns an object with
+ * boundaries and a parallel types Uint8Array, where each element is an index
+ * into Intl.v8BreakIterator.v8BreakTypes (the type of the segment that ends
+ * at the corresponding boundary).
+ * Long texts are split at line and paragraph separators and segmented on
+ * up to threads threads (default 1). Results are the same either way.
+ * Iterators created from v8Rules or v8BinaryRules are always segmented
+ * sequentially, since custom rules may not break at those separators.
+ * Position of the iterator is not changed.
+ */
+function boundaries(iterator, withTypes, threads) {
+  native function NativeJSBreakIteratorBoundaries();
+
+  threads = (threads === undefined) ? 1 : Number(threads) | 0;
+
+  if (withTypes !== true) {
+    return NativeJSBreakIteratorBoundaries(iterator.iterator, false, threads);
+  }
+
+  var result =
+      NativeJSBreakIteratorBoundaries(iterator.iterator, true, threads);
+  return {boundaries: result[0], types: result[1]};
+}
+
+
+/**
+ * Returns segments of the adopted text and their break types, using a
+ * single native call. Result is an object with two parallel arrays,
+ * tokens and types. Segments of type 'none' (spaces, punctuation) are
+ * skipped unless includeNone is true.
+ * Position of the iterator is not changed.
+ */
+function tokens(iterator, includeNone) {
+  native function NativeJSBreakIteratorTokens();
+
+  var result = NativeJSBreakIteratorTokens(iterator.iterator,
+                                           includeNone === true);
+  return {tokens: result[0], types: result[1]};
+}
+
+
+/**
+ * Returns the number of segments in the adopted text. For character
+ * iterators that's the number of user perceived characters.
+ */
+function segmentCount(iterator) {
+  native function NativeJSBreakIteratorSegmentCount();
+  return NativeJSBreakIteratorSegmentCount(iterator.iterator);
+}
+
+
+/**
+ * Returns the position right after the first count segments of the adopted
+ * text, or its length if there are fewer. Useful for truncating text to
+ * a number of user perceived characters.
+ */
+function segmentOffset(iterator, count) {
+  native function NativeJSBreakIteratorSegmentOffset();
+  return NativeJSBreakIteratorSegmentOffset(iterator.iterator,
+                                            Math.max(0, Number(count) | 0));
+}
+
+
+/**
+ * Returns the last boundary at or before the given position. With a word
+ * iterator, that's the place to truncate text without cutting a word.
+ */
+function precedingBoundary(iterator, position) {
+  native function NativeJSBreakIteratorPrecedingBoundary();
+  return NativeJSBreakIteratorPrecedingBoundary(iterator.iterator,
+                                                Number(position) | 0);
+}
+
+
+/**
+ * Greedily wraps the adopted text into lines no wider than width, and
+ * returns an Int32Array of positions where new lines start (0 and the
+ * text length are not included). Width is in UTF-16 code units, or in
+ * terminal columns if columns is true (East Asian wide characters take two
+ * columns). Meant to be used with 'line' iterators.
+ */
+function wrap(iterator, width, columns) {
+  native function NativeJSBreakIteratorWrap();
+
+  width = Number(width);
+  if (isNaN(width) || width < 1) {
+    throw new RangeError('Line width has to be a positive number.');
+  }
+
+  return NativeJSBreakIteratorWrap(iterator.iterator, Math.floor(width),
+                                   columns === true);
 }
 
 
 /**
- * Returns index of the first break in the string and moves current pointer.
+ * Segments a stream of text one chunk at a time. Returns an Int32Array of
+ * boundaries (relative to the start of the stream) that are final; text
+ * after the last one is carried over to the next call. Pass true as isLast
+ * with the final chunk to flush the rest and start a new stream.
+ * Joined results are the same as v8Boundaries() of the whole text, as long
+ * as lines are shorter than 64K characters. Longer lines, and streams
+ * segmented with custom rules, are settled where segmentation can start
+ * over without changing the boundaries that follow.
+ * The stream is kept apart from the adopted text, which, like the position
+ * of the iterator, is not changed. Calling adoptText discards the stream.
  */
-function first(iterator) {
-  native function NativeJSBreakIteratorFirst();
-  return NativeJSBreakIteratorFirst(iterator.iterator);
+function segmentChunk(iterator, chunk, isLast) {
+  native function NativeJSBreakIteratorSegmentChunk();
+
+  var stream = iterator.stream;
+  var result = NativeJSBreakIteratorSegmentChunk(
+      iterator.iterator, String(chunk), stream.offset, !stream.started,
+      isLast === true);
+
+  // Start of the stream is always settled by the first call.
+  stream.started = true;
+  stream.offset = result[1];
+
+  if (isLast === true) {
+    resetStream(iterator);
+  }
+
+  return result[0];
 }
 
 
 /**
- * Returns the index of the next break and moves the pointer.
+ * Returns the rules of the iterator in compiled form, as an Uint8Array.
+ * Passing it as v8BinaryRules option creates an iterator with the same
+ * rules without compiling them again. Only recently returned rules are
+ * accepted, calling v8BinaryRules() again renews them. Rules saved for
+ * later runs have to be registered by the embedder.
  */
-function next(iterator) {
-  native function NativeJSBreakIteratorNext();
-  return NativeJSBreakIteratorNext(iterator.iterator);
+function binaryRules(iterator) {
+  native function NativeJSBreakIteratorBinaryRules();
+  return NativeJSBreakIteratorBinaryRules(iterator.iterator);
 }
 
 
 /**
- * Returns index of the current break.
+ * Returns hits and misses of the segmentation cache shared by iterators
+ * with the same locale and type. The cache is off unless the embedder
+ * enables it.
  */
-function current(iterator) {
-  native function NativeJSBreakIteratorCurrent();
-  return NativeJSBreakIteratorCurrent(iterator.iterator);
+function cacheStats(iterator) {
+  native function NativeJSBreakIteratorCacheStats();
+  return NativeJSBreakIteratorCacheStats(iterator.iterator);
 }
 
 
 /**
- * Returns type of the current break.
+ * Starts a new chunked segmentation stream.
  */
-function breakType(iterator) {
-  native function NativeJSBreakIteratorBreakType();
-  return NativeJSBreakIteratorBreakType(iterator.iterator);
+function resetStream(iterator) {
+  iterator.stream.offset = 0;
+  iterator.stream.started = false;
 }
 
 
+/**
+ * Maps numeric break types returned by v8Boundaries into their names.
+ */
+%SetProperty(Intl.v8BreakIterator, 'v8BreakTypes', freezeArray(BREAK_TYPES),
+             ATTRIBUTES.DONT_ENUM);
+
+
+/**
+ * Iteration methods take the iterator wrapper only, so bound methods call
+ * them directly.
+ * First returns index of the first break in the string and moves current
+ * pointer, next returns the index of the next break and moves the pointer,
+ * current returns index of the current break and breakType returns type of
+ * the current break.
+ */
+native function NativeJSBreakIteratorFirst();
+native function NativeJSBreakIteratorNext();
+native function NativeJSBreakIteratorCurrent();
+native function NativeJSBreakIteratorBreakType();
+
+
 addBoundMethod(Intl.v8BreakIterator, 'adoptText', adoptText, 1);
-addBoundMethod(Intl.v8BreakIterator, 'first', first, 0);
-addBoundMethod(Intl.v8BreakIterator, 'next', next, 0);
-addBoundMethod(Intl.v8BreakIterator, 'current', current, 0);
-addBoundMethod(Intl.v8BreakIterator, 'breakType', breakType, 0);
+addBoundMethod(Intl.v8BreakIterator, 'first', NativeJSBreakIteratorFirst, 0,
+               'iterator');
+addBoundMethod(Intl.v8BreakIterator, 'next', NativeJSBreakIteratorNext, 0,
+               'iterator');
+addBoundMethod(Intl.v8BreakIterator, 'current', NativeJSBreakIteratorCurrent,
+               0, 'iterator');
+addBoundMethod(Intl.v8BreakIterator, 'breakType',
+               NativeJSBreakIteratorBreakType, 0, 'iterator');
+addBoundMethod(Intl.v8BreakIterator, 'v8Boundaries', boundaries, 2);
+addBoundMethod(Intl.v8BreakIterator, 'v8Tokens', tokens, 1);
+addBoundMethod(Intl.v8BreakIterator, 'v8SegmentCount', segmentCount, 0);
+addBoundMethod(Intl.v8BreakIterator, 'v8SegmentOffset', segmentOffset, 1);
+addBoundMethod(Intl.v8BreakIterator, 'v8PrecedingBoundary',
+               precedingBoundary, 1);
+addBoundMethod(Intl.v8BreakIterator, 'v8Wrap', wrap, 2);
+addBoundMethod(Intl.v8BreakIterator, 'v8SegmentChunk', segmentChunk, 2);
+addBoundMethod(Intl.v8BreakIterator, 'v8BinaryRules', binaryRules, 0);
+addBoundMethod(Intl.v8BreakIterator, 'v8CacheStats', cacheStats, 0);
+
+
+exportService('break-iterator', {constructor: Intl.v8BreakIterator});
@@ -14,32 +14,115 @@
 
 #include "src/collator.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/isolate-data.h"
+#include "src/locale-matcher.h"
+#include "src/lru-cache.h"
+#include "src/option-resolver.h"
+#include "src/property-names.h"
 #include "src/utils.h"
 #include "unicode/coll.h"
 #include "unicode/locid.h"
+#include "unicode/tblcoll.h"
 #include "unicode/ucol.h"
 
 namespace v8_i18n {
 
+// Collator compiled from tailoring rules, a copy of a collator whose
+// binary image v8BinaryRules returned, or a clone of a registered one. New
+// collators with the same tailoring are clones of the prototype.
+struct CompiledCollator {
+  icu::Collator* prototype;
+  // Binary image of the prototype, if v8BinaryRules returned it.
+  std::vector<uint8_t> binary;
+  // Held by the cache, and by every collator cloned from the prototype, so
+  // evicted or disposed prototypes outlive their clones.
+  int references;
+};
+
+static const size_t kMaxCompiledCollators = 32;
+
+// Compiled collators of one isolate, keyed by rule source or binary image.
+typedef LruCache<CompiledCollator*, kMaxCompiledCollators>
+    CompiledCollatorCache;
+
+// Collator loaded from a binary image the embedder registered. ICU doesn't
+// copy the image, so it stays here for the life of the process, and
+// compiled collators of each isolate use clones of the prototype.
+struct RegisteredCollator {
+  std::vector<uint8_t> binary;
+  icu::Collator* prototype;
+};
+
+typedef std::map<std::string, RegisteredCollator*> RegisteredCollatorMap;
+
+// Only written before isolates start, so they are shared without locking.
+// Images are loaded on top of the root collator.
+static RegisteredCollatorMap* registered_collators = NULL;
+static icu::Collator* registered_root = NULL;
+
+// Collator options resolved from user options and the Unicode extension of
+// the requested locale.
+struct CollatorOptions {
+  CollatorOptions()
+      : usage("sort"),
+        ignore_punctuation(false),
+        has_numeric(false),
+        numeric(false),
+        collation("default"),
+        has_rules(false) {}
+
+  std::string usage;
+  // Empty if not specified, which is only possible for search usage.
+  std::string sensitivity;
+  bool ignore_punctuation;
+  bool has_numeric;
+  bool numeric;
+  // Empty if not specified.
+  std::string case_first;
+  std::string collation;
+  bool has_rules;
+  icu::UnicodeString rules;
+  // Binary image saved with v8BinaryRules, empty if not specified.
+  std::vector<uint8_t> binary_rules;
+};
+
+static bool ResolveCollatorOptions(
+    v8::Handle<v8::Array>, v8::Handle<v8::Object>, std::string*,
+    CollatorOptions*);
+
 static icu::Collator* InitializeCollator(
-    v8::Handle<v8::String>, v8::Handle<v8::Object>, v8::Handle<v8::Object>);
+    const std::string&, const CollatorOptions&, v8::Handle<v8::Object>,
+    CompiledCollator**);
 
 static icu::Collator* CreateICUCollator(
-    const icu::Locale&, v8::Handle<v8::Object>);
+    const icu::Locale&, const CollatorOptions&, CompiledCollator**);
+
+static icu::Collator* CreateTailoredCollator(
+    const icu::Locale&, const CollatorOptions&, CompiledCollator**);
+
+static CompiledCollator* FindBinaryCollator(const std::vector<uint8_t>&);
+
+static void AddBinaryCollator(icu::Collator*, const std::vector<uint8_t>&);
+
+static void CacheCompiledCollator(const std::string&, CompiledCollator*);
 
-static bool SetBooleanAttribute(
-    UColAttribute, const char*, v8::Handle<v8::Object>, icu::Collator*);
+static void UnreferenceCompiledCollator(CompiledCollator*);
+
+static CompiledCollatorCache* GetCompiledCollators();
 
 static void SetResolvedSettings(
     const icu::Locale&, icu::Collator*, v8::Handle<v8::Object>);
 
 static void SetBooleanSetting(
-    UColAttribute, icu::Collator*, const char*, v8::Handle<v8::Object>);
+    UColAttribute, icu::Collator*, PropertyNames::Name,
+    v8::Handle<v8::Object>);
 
 icu::Collator* Collator::UnpackCollator(v8::Handle<v8::Object> obj) {
-  v8::HandleScope handle_scope;
-
-  if (obj->HasOwnProperty(v8::String::New("collator"))) {
+  if (Utils::HasWrapperType(obj, Utils::COLLATOR_WRAPPER)) {
     return static_cast<icu::Collator*>(
         obj->GetAlignedPointerFromInternalField(0));
   }
@@ -57,6 +140,11 @@ void Collator::DeleteCollator(v8::Isolate* isolate,
   v8::HandleScope handle_scope(isolate);
   v8::Local<v8::Object> handle = v8::Local<v8::Object>::New(isolate, *object);
   delete UnpackCollator(handle);
+  CompiledCollator* compiled = static_cast<CompiledCollator*>(
+      handle->GetAlignedPointerFromInternalField(1));
+  if (compiled) {
+    UnreferenceCompiledCollator(compiled);
+  }
 
   // Then dispose of the persistent handle to JS object.
   object->Dispose(isolate);
@@ -78,10 +166,9 @@ static v8::Handle<v8::Value> ThrowExceptionForICUError(const char* message) {
 // static
 void Collator::JSInternalCompare(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
-  if (args.Length() != 3 || !args[0]->IsObject() ||
-      !args[1]->IsString() || !args[2]->IsString()) {
+  if (args.Length() != 3 || !args[0]->IsObject()) {
     v8::ThrowException(v8::Exception::SyntaxError(
-        v8::String::New("Collator and two string arguments are required.")));
+        v8::String::New("Collator and two arguments are required.")));
     return;
   }
 
@@ -91,8 +178,19 @@ void Collator::JSInternalCompare(
     return;
   }
 
-  v8::String::Value string_value1(args[1]);
-  v8::String::Value string_value2(args[2]);
+  // Arguments are converted here, so bound compare can call us directly.
+  v8::Local<v8::String> x = args[1]->ToString();
+  if (x.IsEmpty()) {
+    // Exception is pending.
+    return;
+  }
+  v8::Local<v8::String> y = args[2]->ToString();
+  if (y.IsEmpty()) {
+    return;
+  }
+
+  v8::String::Value string_value1(x);
+  v8::String::Value string_value2(y);
   const UChar* string1 = reinterpret_cast<const UChar*>(*string_value1);
   const UChar* string2 = reinterpret_cast<const UChar*>(*string_value2);
   UErrorCode status = U_ZERO_ERROR;
@@ -108,18 +206,73 @@ void Collator::JSInternalCompare(
   args.GetReturnValue().Set(result);
 }
 
+// static
+void Collator::JSInternalBinaryRules(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  icu::Collator* collator = UnpackCollator(args[0]->ToObject());
+  if (!collator) {
+    ThrowUnexpectedObjectError();
+    return;
+  }
+
+  // Ask for the size first.
+  icu::RuleBasedCollator* rule_based_collator =
+      static_cast<icu::RuleBasedCollator*>(collator);
+  UErrorCode status = U_ZERO_ERROR;
+  int32_t length = rule_based_collator->cloneBinary(NULL, 0, status);
+  if (status != U_BUFFER_OVERFLOW_ERROR) {
+    ThrowExceptionForICUError(
+        "Internal error. Couldn't get binary image of the collator.");
+    return;
+  }
+
+  std::vector<uint8_t> binary(length);
+  status = U_ZERO_ERROR;
+  rule_based_collator->cloneBinary(&binary[0], length, status);
+  if (U_FAILURE(status)) {
+    ThrowExceptionForICUError(
+        "Internal error. Couldn't get binary image of the collator.");
+    return;
+  }
+
+  // ICU doesn't validate binary images, so they are never loaded. Only
+  // images returned here are accepted back, as copies of the collator.
+  AddBinaryCollator(collator, binary);
+
+  args.GetReturnValue().Set(Utils::NewUint8Array(&binary[0], length));
+}
+
 void Collator::JSCreateCollator(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
-  if (args.Length() != 3 || !args[0]->IsString() || !args[1]->IsObject() ||
+  if (args.Length() != 3 || !args[0]->IsArray() || !args[1]->IsObject() ||
       !args[2]->IsObject()) {
     v8::ThrowException(v8::Exception::SyntaxError(
         v8::String::New("Internal error, wrong parameters.")));
     return;
   }
 
+  // Options are read before anything else is created, so user getters
+  // that throw leave nothing behind.
+  std::string requested_locale;
+  CollatorOptions options;
+  if (!ResolveCollatorOptions(v8::Local<v8::Array>::Cast(args[0]),
+                              args[1]->ToObject(),
+                              &requested_locale,
+                              &options)) {
+    return;
+  }
+
+  if (!options.binary_rules.empty() &&
+      !FindBinaryCollator(options.binary_rules)) {
+    v8::ThrowException(v8::Exception::TypeError(v8::String::New(
+        "Unknown v8BinaryRules. Only images returned by v8BinaryRules() "
+        "or registered by the embedder are accepted.")));
+    return;
+  }
+
   v8::Isolate* isolate = args.GetIsolate();
   v8::Local<v8::ObjectTemplate> intl_collator_template =
-      Utils::GetTemplate(isolate);
+      Utils::GetTemplate2(isolate);
 
   // Create an empty object wrapper.
   v8::Local<v8::Object> local_object = intl_collator_template->NewInstance();
@@ -130,9 +283,11 @@ void Collator::JSCreateCollator(
     return;
   }
 
-  // Set collator as internal field of the resulting JS object.
+  // Set collator as internal field of the resulting JS object, and the
+  // compiled collator it was cloned from, if any, as the second one.
+  CompiledCollator* compiled = NULL;
   icu::Collator* collator = InitializeCollator(
-      args[0]->ToString(), args[1]->ToObject(), args[2]->ToObject());
+      requested_locale, options, args[2]->ToObject(), &compiled);
 
   if (!collator) {
     v8::ThrowException(v8::Exception::Error(v8::String::New(
@@ -140,15 +295,9 @@ void Collator::JSCreateCollator(
     return;
   } else {
     local_object->SetAlignedPointerInInternalField(0, collator);
+    local_object->SetAlignedPointerInInternalField(1, compiled);
 
-    // Make it safer to unpack later on.
-    v8::TryCatch try_catch;
-    local_object->Set(v8::String::New("collator"), v8::String::New("valid"));
-    if (try_catch.HasCaught()) {
-      v8::ThrowException(v8::Exception::Error(
-          v8::String::New("Internal error, couldn't set property.")));
-      return;
-    }
+    Utils::SetWrapperType(local_object, Utils::COLLATOR_WRAPPER);
   }
 
   v8::Persistent<v8::Object> wrapper(isolate, local_object);
@@ -158,17 +307,114 @@ void Collator::JSCreateCollator(
   wrapper.ClearAndLeak();
 }
 
-static icu::Collator* InitializeCollator(v8::Handle<v8::String> locale,
-                                         v8::Handle<v8::Object> options,
-                                         v8::Handle<v8::Object> resolved) {
+// Reads user options in the order ECMA-402 specifies, resolves the locale,
+// and applies Unicode extension keys the options didn't override.
+// Returns false with an exception pending on invalid options.
+static bool ResolveCollatorOptions(v8::Handle<v8::Array> requested_locales,
+                                   v8::Handle<v8::Object> user_options,
+                                   std::string* requested_locale,
+                                   CollatorOptions* options) {
+  static const char* const kUsageValues[] = {"sort", "search", NULL};
+  static const char* const kCaseFirstValues[] = {
+    "false", "lower", "upper", NULL
+  };
+  static const char* const kSensitivityValues[] = {
+    "base", "accent", "case", "variant", NULL
+  };
+  // Allowed -u-co- values. List taken from:
+  // http://unicode.org/repos/cldr/trunk/common/bcp47/collation.xml
+  static const char* const kCollationValues[] = {
+    "big5han", "dict", "direct", "ducet", "gb2312", "phonebk", "phonetic",
+    "pinyin", "reformed", "searchjl", "stroke", "trad", "unihan", "zhuyin",
+    NULL
+  };
+
+  OptionResolver resolver(user_options, "collator");
+  bool found = false;
+  if (!resolver.GetString(PropertyNames::USAGE, kUsageValues,
+                          &options->usage, &found)) {
+    return false;
+  }
+
+  LocaleMatch match;
+  if (!resolver.ResolveLocale("collator", requested_locales, &match)) {
+    return false;
+  }
+
+  if (!resolver.GetBoolean(PropertyNames::NUMERIC, &options->numeric,
+                           &options->has_numeric) ||
+      !resolver.GetString(PropertyNames::CASE_FIRST, kCaseFirstValues,
+                          &options->case_first, &found)) {
+    return false;
+  }
+
+  bool has_sensitivity = false;
+  if (!resolver.GetString(PropertyNames::SENSITIVITY, kSensitivityValues,
+                          &options->sensitivity, &has_sensitivity) ||
+      !resolver.GetBoolean(PropertyNames::IGNORE_PUNCTUATION,
+                           &options->ignore_punctuation, &found)) {
+    return false;
+  }
+  if (!has_sensitivity && options->usage == "sort") {
+    options->sensitivity = "variant";
+  }
+
+  // Custom tailoring rules extend the rules of the locale. A binary image,
+  // as returned by v8BinaryRules(), takes precedence over rule source.
+  if (!resolver.GetBinary(PropertyNames::V8_BINARY_RULES,
+                          &options->binary_rules, &found) ||
+      !resolver.GetUnicodeString(PropertyNames::V8_RULES, &options->rules,
+                                 &options->has_rules)) {
+    return false;
+  }
+
+  // ICU can't take kn and kf parameters through localeID, so they are
+  // applied as attributes, unless options already set them.
+  ExtensionMap extension;
+  OptionResolver::ParseExtension(match.extension, &extension);
+  ExtensionMap::const_iterator it = extension.find("kn");
+  if (!options->has_numeric && it != extension.end()) {
+    // Boolean keys default to true without a value.
+    options->has_numeric = true;
+    options->numeric = it->second.empty() || it->second == "true";
+  }
+
+  it = extension.find("kf");
+  if (options->case_first.empty() && it != extension.end()) {
+    options->case_first = it->second;
+  }
+
+  // -co- has to be part of the locale, but only for usage: sort, and its
+  // value can't be 'standard' or 'search'.
+  requested_locale->assign(match.locale);
+  it = extension.find("co");
+  if (it != extension.end() && options->usage == "sort") {
+    for (const char* const* value = kCollationValues; *value; ++value) {
+      if (it->second == *value) {
+        requested_locale->append("-u-co-").append(it->second);
+        // ICU can't tell us what the collation is, so save user's input.
+        options->collation = it->second;
+        break;
+      }
+    }
+  } else if (options->usage == "search") {
+    requested_locale->append("-u-co-search");
+  }
+
+  return true;
+}
+
+static icu::Collator* InitializeCollator(const std::string& locale,
+                                         const CollatorOptions& options,
+                                         v8::Handle<v8::Object> resolved,
+                                         CompiledCollator** compiled) {
   // Convert BCP47 into ICU locale format.
   UErrorCode status = U_ZERO_ERROR;
   icu::Locale icu_locale;
   char icu_result[ULOC_FULLNAME_CAPACITY];
   int icu_length = 0;
-  v8::String::AsciiValue bcp47_locale(locale);
-  if (bcp47_locale.length() != 0) {
-    uloc_forLanguageTag(*bcp47_locale, icu_result, ULOC_FULLNAME_CAPACITY,
+  if (!locale.empty()) {
+    uloc_forLanguageTag(locale.c_str(), icu_result, ULOC_FULLNAME_CAPACITY,
                         &icu_length, &status);
     if (U_FAILURE(status) || icu_length == 0) {
       return NULL;
@@ -176,11 +422,14 @@ static icu::Collator* InitializeCollator(v8::Handle<v8::String> locale,
     icu_locale = icu::Locale(icu_result);
   }
 
-  icu::Collator* collator = CreateICUCollator(icu_locale, options);
+  icu::Collator* collator = CreateICUCollator(icu_locale, options, compiled);
   if (!collator) {
     // Remove extensions and try again.
     icu::Locale no_extension_locale(icu_locale.getBaseName());
-    collator = CreateICUCollator(no_extension_locale, options);
+    collator = CreateICUCollator(no_extension_locale, options, compiled);
+    if (!collator) {
+      return NULL;
+    }
 
     // Set resolved settings (pattern, numbering system).
     SetResolvedSettings(no_extension_locale, collator, resolved);
@@ -188,34 +437,53 @@ static icu::Collator* InitializeCollator(v8::Handle<v8::String> locale,
     SetResolvedSettings(icu_locale, collator, resolved);
   }
 
+  resolved->Set(PropertyNames::Get(PropertyNames::REQUESTED_LOCALE),
+                v8::String::New(locale.c_str()));
+  resolved->Set(PropertyNames::Get(PropertyNames::USAGE),
+                v8::String::New(options.usage.c_str()));
+  resolved->Set(PropertyNames::Get(PropertyNames::COLLATION),
+                v8::String::New(options.collation.c_str()));
+
   return collator;
 }
 
-static icu::Collator* CreateICUCollator(
-    const icu::Locale& icu_locale, v8::Handle<v8::Object> options) {
+// Sets |compiled| to the compiled collator a tailored collator was cloned
+// from, after adding a reference to it for the caller.
+static icu::Collator* CreateICUCollator(const icu::Locale& icu_locale,
+                                        const CollatorOptions& options,
+                                        CompiledCollator** compiled) {
   // Make collator from options.
   icu::Collator* collator = NULL;
   UErrorCode status = U_ZERO_ERROR;
-  collator = icu::Collator::createInstance(icu_locale, status);
+  if (options.has_rules || !options.binary_rules.empty()) {
+    collator = CreateTailoredCollator(icu_locale, options, compiled);
+    if (!collator) {
+      return NULL;
+    }
+  } else {
+    collator = icu::Collator::createInstance(icu_locale, status);
 
-  if (U_FAILURE(status)) {
-    delete collator;
-    return NULL;
+    if (U_FAILURE(status)) {
+      delete collator;
+      return NULL;
+    }
   }
 
   // Set flags first, and then override them with sensitivity if necessary.
-  SetBooleanAttribute(UCOL_NUMERIC_COLLATION, "numeric", options, collator);
+  if (options.has_numeric) {
+    collator->setAttribute(UCOL_NUMERIC_COLLATION,
+                           options.numeric ? UCOL_ON : UCOL_OFF, status);
+  }
 
   // Normalization is always on, by the spec. We are free to optimize
   // if the strings are already normalized (but we don't have a way to tell
   // that right now).
   collator->setAttribute(UCOL_NORMALIZATION_MODE, UCOL_ON, status);
 
-  icu::UnicodeString case_first;
-  if (Utils::ExtractStringSetting(options, "caseFirst", &case_first)) {
-    if (case_first == UNICODE_STRING_SIMPLE("upper")) {
+  if (!options.case_first.empty()) {
+    if (options.case_first == "upper") {
       collator->setAttribute(UCOL_CASE_FIRST, UCOL_UPPER_FIRST, status);
-    } else if (case_first == UNICODE_STRING_SIMPLE("lower")) {
+    } else if (options.case_first == "lower") {
       collator->setAttribute(UCOL_CASE_FIRST, UCOL_LOWER_FIRST, status);
     } else {
       // Default (false/off).
@@ -223,13 +491,12 @@ static icu::Collator* CreateICUCollator(
     }
   }
 
-  icu::UnicodeString sensitivity;
-  if (Utils::ExtractStringSetting(options, "sensitivity", &sensitivity)) {
-    if (sensitivity == UNICODE_STRING_SIMPLE("base")) {
+  if (!options.sensitivity.empty()) {
+    if (options.sensitivity == "base") {
       collator->setStrength(icu::Collator::PRIMARY);
-    } else if (sensitivity == UNICODE_STRING_SIMPLE("accent")) {
+    } else if (options.sensitivity == "accent") {
       collator->setStrength(icu::Collator::SECONDARY);
-    } else if (sensitivity == UNICODE_STRING_SIMPLE("case")) {
+    } else if (options.sensitivity == "case") {
       collator->setStrength(icu::Collator::PRIMARY);
       collator->setAttribute(UCOL_CASE_LEVEL, UCOL_ON, status);
     } else {
@@ -238,86 +505,283 @@ static icu::Collator* CreateICUCollator(
     }
   }
 
-  bool ignore;
-  if (Utils::ExtractBooleanSetting(options, "ignorePunctuation", &ignore)) {
-    if (ignore) {
-      collator->setAttribute(UCOL_ALTERNATE_HANDLING, UCOL_SHIFTED, status);
+  if (options.ignore_punctuation) {
+    collator->setAttribute(UCOL_ALTERNATE_HANDLING, UCOL_SHIFTED, status);
+  }
+
+  return collator;
+}
+
+// Clones the collator for custom tailoring rules, or for a binary image
+// returned by v8BinaryRules. Rules are compiled once per isolate, while
+// they stay cached. Rules extend the locale's own tailoring.
+static icu::Collator* CreateTailoredCollator(const icu::Locale& icu_locale,
+                                             const CollatorOptions& options,
+                                             CompiledCollator** compiled) {
+  CompiledCollator* found = NULL;
+  if (!options.binary_rules.empty()) {
+    found = FindBinaryCollator(options.binary_rules);
+  } else if (options.has_rules) {
+    // Rule source is the key, as raw UTF-16 bytes.
+    std::string key(icu_locale.getName());
+    key.push_back('/');
+    key.append(reinterpret_cast<const char*>(options.rules.getBuffer()),
+               options.rules.length() * sizeof(UChar));
+
+    CompiledCollator** cached = GetCompiledCollators()->Find(key);
+    if (cached) {
+      found = *cached;
+    } else {
+      UErrorCode status = U_ZERO_ERROR;
+      icu::Collator* locale_collator =
+          icu::Collator::createInstance(icu_locale, status);
+      icu::Collator* prototype = NULL;
+      if (U_SUCCESS(status)) {
+        icu::UnicodeString all_rules(
+            static_cast<icu::RuleBasedCollator*>(locale_collator)->getRules());
+        all_rules.append(options.rules);
+        prototype = new icu::RuleBasedCollator(all_rules, status);
+      }
+      delete locale_collator;
+
+      if (U_FAILURE(status)) {
+        delete prototype;
+        return NULL;
+      }
+
+      found = new CompiledCollator();
+      found->prototype = prototype;
+      found->references = 0;
+      CacheCompiledCollator(key, found);
     }
   }
 
+  if (!found) {
+    return NULL;
+  }
+
+  icu::Collator* collator = found->prototype->clone();
+  if (collator) {
+    ++found->references;
+    *compiled = found;
+  }
   return collator;
 }
 
-static bool SetBooleanAttribute(UColAttribute attribute,
-                                const char* name,
-                                v8::Handle<v8::Object> options,
-                                icu::Collator* collator) {
+// Returns the compiled collator v8BinaryRules returned the image for, or
+// NULL if the image is unknown, or was dropped from the cache.
+static CompiledCollator* FindBinaryCollator(
+    const std::vector<uint8_t>& binary) {
+  std::string key =
+      Utils::BinaryKey(&binary[0], static_cast<uint32_t>(binary.size()));
+  CompiledCollator** cached = GetCompiledCollators()->Find(key);
+  if (cached) {
+    return (*cached)->binary == binary ? *cached : NULL;
+  }
+
+  if (!registered_collators) {
+    return NULL;
+  }
+  RegisteredCollatorMap::const_iterator it = registered_collators->find(key);
+  if (it == registered_collators->end() || it->second->binary != binary) {
+    return NULL;
+  }
+
+  icu::Collator* prototype = it->second->prototype->clone();
+  if (!prototype) {
+    return NULL;
+  }
+
+  CompiledCollator* compiled = new CompiledCollator();
+  compiled->prototype = prototype;
+  compiled->binary = binary;
+  compiled->references = 0;
+  CacheCompiledCollator(key, compiled);
+  return compiled;
+}
+
+// Caches a copy of the collator under its binary image, or renews the
+// cached one.
+static void AddBinaryCollator(icu::Collator* collator,
+                              const std::vector<uint8_t>& binary) {
+  std::string key =
+      Utils::BinaryKey(&binary[0], static_cast<uint32_t>(binary.size()));
+  CompiledCollator** cached = GetCompiledCollators()->Find(key);
+  if (cached && (*cached)->binary == binary) {
+    return;
+  }
+
+  icu::Collator* prototype = collator->clone();
+  if (!prototype) {
+    return;
+  }
+
+  CompiledCollator* compiled = new CompiledCollator();
+  compiled->prototype = prototype;
+  compiled->binary = binary;
+  compiled->references = 0;
+  if (cached) {
+    // Another image with the same digest. The newer one wins.
+    UnreferenceCompiledCollator(*cached);
+    ++compiled->references;
+    *cached = compiled;
+  } else {
+    CacheCompiledCollator(key, compiled);
+  }
+}
+
+// Adds the compiled collator under the key, which must not be cached yet,
+// dropping the least recently used one if the cache is full.
+static void CacheCompiledCollator(const std::string& key,
+                                  CompiledCollator* compiled) {
+  CompiledCollator* evicted = NULL;
+  ++compiled->references;
+  *GetCompiledCollators()->Insert(key, &evicted) = compiled;
+  if (evicted) {
+    UnreferenceCompiledCollator(evicted);
+  }
+}
+
+static void UnreferenceCompiledCollator(CompiledCollator* compiled) {
+  if (--compiled->references == 0) {
+    delete compiled->prototype;
+    delete compiled;
+  }
+}
+
+// Collators still cloned from a compiled collator keep it alive.
+static void DeleteCompiledCollators(v8::Isolate* isolate, void* value) {
+  CompiledCollatorCache* cache = static_cast<CompiledCollatorCache*>(value);
+  CompiledCollator* compiled = NULL;
+  while (cache->RemoveOldest(&compiled)) {
+    UnreferenceCompiledCollator(compiled);
+  }
+  delete cache;
+}
+
+// static
+bool Collator::RegisterBinaryRules(const uint8_t* data, size_t length) {
+  if (!data || length == 0 || length > 0x7FFFFFFF) {
+    return false;
+  }
+
+  std::string key = Utils::BinaryKey(data, static_cast<uint32_t>(length));
+  std::vector<uint8_t> binary(data, data + length);
+  if (!registered_collators) {
+    registered_collators = new RegisteredCollatorMap();
+  } else if (registered_collators->count(key)) {
+    // Either registered before, or another image with the same digest.
+    return (*registered_collators)[key]->binary == binary;
+  }
+
   UErrorCode status = U_ZERO_ERROR;
-  bool result;
-  if (Utils::ExtractBooleanSetting(options, name, &result)) {
-    collator->setAttribute(attribute, result ? UCOL_ON : UCOL_OFF, status);
+  if (!registered_root) {
+    registered_root =
+        icu::Collator::createInstance(icu::Locale::getRoot(), status);
     if (U_FAILURE(status)) {
+      delete registered_root;
+      registered_root = NULL;
       return false;
     }
   }
 
+  RegisteredCollator* registered = new RegisteredCollator();
+  registered->binary.swap(binary);
+  registered->prototype = new icu::RuleBasedCollator(
+      &registered->binary[0], static_cast<int32_t>(length),
+      static_cast<icu::RuleBasedCollator*>(registered_root), status);
+  if (U_FAILURE(status)) {
+    delete registered->prototype;
+    delete registered;
+    return false;
+  }
+
+  (*registered_collators)[key] = registered;
   return true;
 }
 
+// Compiled collators are cached per isolate.
+static CompiledCollatorCache* GetCompiledCollators() {
+  IsolateData* data = IsolateData::Current();
+  CompiledCollatorCache* cache = static_cast<CompiledCollatorCache*>(
+      data->Get(IsolateData::COMPILED_COLLATORS));
+  if (!cache) {
+    cache = new CompiledCollatorCache();
+    data->Set(IsolateData::COMPILED_COLLATORS, cache,
+              &DeleteCompiledCollators);
+  }
+  return cache;
+}
+
 static void SetResolvedSettings(const icu::Locale& icu_locale,
                                 icu::Collator* collator,
                                 v8::Handle<v8::Object> resolved) {
-  SetBooleanSetting(UCOL_NUMERIC_COLLATION, collator, "numeric", resolved);
+  SetBooleanSetting(UCOL_NUMERIC_COLLATION, collator,
+                    PropertyNames::NUMERIC, resolved);
 
   UErrorCode status = U_ZERO_ERROR;
 
   switch (collator->getAttribute(UCOL_CASE_FIRST, status)) {
     case UCOL_LOWER_FIRST:
-      resolved->Set(v8::String::New("caseFirst"), v8::String::New("lower"));
+      resolved->Set(PropertyNames::Get(PropertyNames::CASE_FIRST),
+                    v8::String::New("lower"));
       break;
     case UCOL_UPPER_FIRST:
-      resolved->Set(v8::String::New("caseFirst"), v8::String::New("upper"));
+      resolved->Set(PropertyNames::Get(PropertyNames::CASE_FIRST),
+                    v8::String::New("upper"));
       break;
     default:
-      resolved->Set(v8::String::New("caseFirst"), v8::String::New("false"));
+      resolved->Set(PropertyNames::Get(PropertyNames::CASE_FIRST),
+                    v8::String::New("false"));
   }
 
   switch (collator->getAttribute(UCOL_STRENGTH, status)) {
     case UCOL_PRIMARY: {
-      resolved->Set(v8::String::New("strength"), v8::String::New("primary"));
+      resolved->Set(PropertyNames::Get(PropertyNames::STRENGTH),
+                    v8::String::New("primary"));
 
       // case level: true + s1 -> case, s1 -> base.
       if (UCOL_ON == collator->getAttribute(UCOL_CASE_LEVEL, status)) {
-        resolved->Set(v8::String::New("sensitivity"), v8::String::New("case"));
+        resolved->Set(PropertyNames::Get(PropertyNames::SENSITIVITY),
+                      v8::String::New("case"));
       } else {
-        resolved->Set(v8::String::New("sensitivity"), v8::String::New("base"));
+        resolved->Set(PropertyNames::Get(PropertyNames::SENSITIVITY),
+                      v8::String::New("base"));
       }
       break;
     }
     case UCOL_SECONDARY:
-      resolved->Set(v8::String::New("strength"), v8::String::New("secondary"));
-      resolved->Set(v8::String::New("sensitivity"), v8::String::New("accent"));
+      resolved->Set(PropertyNames::Get(PropertyNames::STRENGTH),
+                    v8::String::New("secondary"));
+      resolved->Set(PropertyNames::Get(PropertyNames::SENSITIVITY),
+                    v8::String::New("accent"));
       break;
     case UCOL_TERTIARY:
-      resolved->Set(v8::String::New("strength"), v8::String::New("tertiary"));
-      resolved->Set(v8::String::New("sensitivity"), v8::String::New("variant"));
+      resolved->Set(PropertyNames::Get(PropertyNames::STRENGTH),
+                    v8::String::New("tertiary"));
+      resolved->Set(PropertyNames::Get(PropertyNames::SENSITIVITY),
+                    v8::String::New("variant"));
       break;
     case UCOL_QUATERNARY:
       // We shouldn't get quaternary and identical from ICU, but if we do
       // put them into variant.
-      resolved->Set(v8::String::New("strength"), v8::String::New("quaternary"));
-      resolved->Set(v8::String::New("sensitivity"), v8::String::New("variant"));
+      resolved->Set(PropertyNames::Get(PropertyNames::STRENGTH),
+                    v8::String::New("quaternary"));
+      resolved->Set(PropertyNames::Get(PropertyNames::SENSITIVITY),
+                    v8::String::New("variant"));
       break;
     default:
-      resolved->Set(v8::String::New("strength"), v8::String::New("identical"));
-      resolved->Set(v8::String::New("sensitivity"), v8::String::New("variant"));
+      resolved->Set(PropertyNames::Get(PropertyNames::STRENGTH),
+                    v8::String::New("identical"));
+      resolved->Set(PropertyNames::Get(PropertyNames::SENSITIVITY),
+                    v8::String::New("variant"));
   }
 
   if (UCOL_SHIFTED == collator->getAttribute(UCOL_ALTERNATE_HANDLING, status)) {
-    resolved->Set(v8::String::New("ignorePunctuation"),
+    resolved->Set(PropertyNames::Get(PropertyNames::IGNORE_PUNCTUATION),
                   v8::Boolean::New(true));
   } else {
-    resolved->Set(v8::String::New("ignorePunctuation"),
+    resolved->Set(PropertyNames::Get(PropertyNames::IGNORE_PUNCTUATION),
                   v8::Boolean::New(false));
   }
 
@@ -327,22 +791,24 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
   uloc_toLanguageTag(
       icu_locale.getName(), result, ULOC_FULLNAME_CAPACITY, FALSE, &status);
   if (U_SUCCESS(status)) {
-    resolved->Set(v8::String::New("locale"), v8::String::New(result));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New(result));
   } else {
     // This would never happen, since we got the locale from ICU.
-    resolved->Set(v8::String::New("locale"), v8::String::New("und"));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New("und"));
   }
 }
 
 static void SetBooleanSetting(UColAttribute attribute,
                               icu::Collator* collator,
-                              const char* property,
+                              PropertyNames::Name property,
                               v8::Handle<v8::Object> resolved) {
   UErrorCode status = U_ZERO_ERROR;
   if (UCOL_ON == collator->getAttribute(attribute, status)) {
-    resolved->Set(v8::String::New(property), v8::Boolean::New(true));
+    resolved->Set(PropertyNames::Get(property), v8::Boolean::New(true));
   } else {
-    resolved->Set(v8::String::New(property), v8::Boolean::New(false));
+    resolved->Set(PropertyNames::Get(property), v8::Boolean::New(false));
   }
 }
 
@@ -42,9 +42,24 @@ class Collator {
 
   // Compare two strings and returns -1, 0 and 1 depending on
   // whether string1 is smaller than, equal to or larger than string2.
+  // Arguments are converted to strings first.
   static void JSInternalCompare(
       const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  // Returns the binary image of the collator as an Uint8Array. Passing it
+  // back as v8BinaryRules option in the same isolate, or after registering
+  // it with RegisterBinaryRules, clones the collator without compiling
+  // tailoring rules.
+  static void JSInternalBinaryRules(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Loads a binary image the embedder trusts on top of the root collator,
+  // so v8BinaryRules options with the same bytes are accepted in every
+  // isolate. Images are loaded once per process, and kept as long as it
+  // runs. Has to be called before isolates run extension code on other
+  // threads. Returns false if ICU can't load the image.
+  static bool RegisterBinaryRules(const uint8_t* data, size_t length);
+
  private:
   Collator() {}
 };
@@ -27,51 +27,18 @@ function initializeCollator(collator, locales, options) {
     throw new TypeError('Trying to re-initialize Collator object.');
   }
 
+  var requestedLocales = initializeLocaleList(locales);
+
   if (options === undefined) {
     options = {};
+  } else {
+    options = toObject(options);
   }
 
-  var getOption = getGetOption(options, 'collator');
-
-  var internalOptions = {};
-
-  defineWEProperty(internalOptions, 'usage', getOption(
-    'usage', 'string', ['sort', 'search'], 'sort'));
-
-  var sensitivity = getOption('sensitivity', 'string',
-                              ['base', 'accent', 'case', 'variant']);
-  if (sensitivity === undefined && internalOptions.usage === 'sort') {
-    sensitivity = 'variant';
-  }
-  defineWEProperty(internalOptions, 'sensitivity', sensitivity);
-
-  defineWEProperty(internalOptions, 'ignorePunctuation', getOption(
-    'ignorePunctuation', 'boolean', undefined, false));
-
-  var locale = resolveLocale('collator', locales, options);
-
-  // ICU can't take kb, kc... parameters through localeID, so we need to pass
-  // them as options.
-  // One exception is -co- which has to be part of the extension, but only for
-  // usage: sort, and its value can't be 'standard' or 'search'.
-  var extensionMap = parseExtension(locale.extension);
-  setOptions(
-      options, extensionMap, COLLATOR_KEY_MAP, getOption, internalOptions);
-
-  var collation = 'default';
-  var extension = '';
-  if (extensionMap.hasOwnProperty('co') && internalOptions.usage === 'sort') {
-    if (ALLOWED_CO_VALUES.indexOf(extensionMap.co) !== -1) {
-      extension = '-u-co-' + extensionMap.co;
-      // ICU can't tell us what the collation is, so save user's input.
-      collation = extensionMap.co;
-    }
-  } else if (internalOptions.usage === 'search') {
-    extension = '-u-co-search';
-  }
-  defineWEProperty(internalOptions, 'collation', collation);
-
-  var requestedLocale = locale.locale + extension;
+  // Options are validated, and the locale resolved, natively in the same
+  // call that creates ICU collator. Options are read in the order the spec
+  // defines: usage, localeMatcher, numeric, caseFirst, sensitivity,
+  // ignorePunctuation, followed by v8BinaryRules and v8Rules.
 
   // We define all properties C++ code may produce, to prevent security
   // problems. If malicious user decides to redefine Object.prototype.locale
@@ -79,18 +46,18 @@ function initializeCollator(collator, locales, options) {
   // Object.defineProperties will either succeed defining or throw an error.
   var resolved = Object.defineProperties({}, {
     caseFirst: {writable: true},
-    collation: {value: internalOptions.collation, writable: true},
+    collation: {writable: true},
     ignorePunctuation: {writable: true},
     locale: {writable: true},
     numeric: {writable: true},
-    requestedLocale: {value: requestedLocale, writable: true},
+    requestedLocale: {writable: true},
     sensitivity: {writable: true},
     strength: {writable: true},
-    usage: {value: internalOptions.usage, writable: true}
+    usage: {writable: true}
   });
 
-  var internalCollator = NativeJSCreateCollator(requestedLocale,
-                                                internalOptions,
+  var internalCollator = NativeJSCreateCollator(requestedLocales,
+                                                options,
                                                 resolved);
 
   // Writable, configurable and enumerable are set to false by default.
@@ -186,9 +153,30 @@ function initializeCollator(collator, locales, options) {
  * the sort order, or x comes after y in the sort order, respectively.
  */
 function compare(collator, x, y) {
-  native function NativeJSInternalCompare();
-  return NativeJSInternalCompare(collator.collator, String(x), String(y));
+  return NativeJSInternalCompare(collator.collator, x, y);
 };
 
 
-addBoundMethod(Intl.Collator, 'compare', compare, 2);
+/**
+ * Returns the binary image of the collator, with its tailoring, as an
+ * Uint8Array. Passing it as v8BinaryRules option creates a collator with
+ * the same tailoring without compiling rules again. Only recently returned
+ * images are accepted, calling v8BinaryRules() again renews them. Images
+ * saved for later runs have to be registered by the embedder.
+ */
+function collatorBinaryRules(collator) {
+  native function NativeJSInternalCollatorBinaryRules();
+  return NativeJSInternalCollatorBinaryRules(collator.collator);
+}
+
+
+// Converts both arguments to strings natively.
+native function NativeJSInternalCompare();
+
+
+addBoundMethod(Intl.Collator, 'compare', NativeJSInternalCompare, 2,
+               'collator');
+addBoundMethod(Intl.Collator, 'v8BinaryRules', collatorBinaryRules, 0);
+
+
+exportService('collator', {constructor: Intl.Collator, compare: compare});
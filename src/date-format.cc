@@ -14,8 +14,14 @@
 
 #include "src/date-format.h"
 
+#include <math.h>
 #include <string.h>
 
+#include <string>
+
+#include "src/locale-matcher.h"
+#include "src/option-resolver.h"
+#include "src/property-names.h"
 #include "src/utils.h"
 #include "unicode/calendar.h"
 #include "unicode/dtfmtsym.h"
@@ -27,20 +33,32 @@
 
 namespace v8_i18n {
 
-static icu::SimpleDateFormat* InitializeDateTimeFormat(v8::Handle<v8::String>,
-                                                       v8::Handle<v8::Object>,
-                                                       v8::Handle<v8::Object>);
+// Largest absolute time value a Date can hold, in milliseconds.
+static const double kMaxTimeInMs = 8.64e15;
+
+// Date format options resolved from user options.
+struct DateFormatOptions {
+  // LDML skeleton the pattern is generated from.
+  std::string skeleton;
+  // Canonical time zone name, empty for the default time zone.
+  std::string time_zone;
+};
+
+static bool ResolveDateFormatOptions(v8::Handle<v8::Array>,
+                                     v8::Handle<v8::Object>,
+                                     std::string*,
+                                     DateFormatOptions*);
+static icu::SimpleDateFormat* InitializeDateTimeFormat(
+    const std::string&, const DateFormatOptions&, v8::Handle<v8::Object>);
 static icu::SimpleDateFormat* CreateICUDateFormat(const icu::Locale&,
-                                                  v8::Handle<v8::Object>);
+                                                  const DateFormatOptions&);
 static void SetResolvedSettings(const icu::Locale&,
                                 icu::SimpleDateFormat*,
                                 v8::Handle<v8::Object>);
 
 icu::SimpleDateFormat* DateFormat::UnpackDateFormat(
     v8::Handle<v8::Object> obj) {
-  v8::HandleScope handle_scope;
-
-  if (obj->HasOwnProperty(v8::String::New("dateFormat"))) {
+  if (Utils::HasWrapperType(obj, Utils::DATE_FORMAT_WRAPPER)) {
     return static_cast<icu::SimpleDateFormat*>(
         obj->GetAlignedPointerFromInternalField(0));
   }
@@ -65,14 +83,10 @@ void DateFormat::DeleteDateFormat(v8::Isolate* isolate,
 
 void DateFormat::JSInternalFormat(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
-  double millis = 0.0;
-  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsDate()) {
+  if (args.Length() < 1 || !args[0]->IsObject()) {
     v8::ThrowException(v8::Exception::Error(
-        v8::String::New(
-            "Internal error. Formatter and date value have to be specified.")));
+        v8::String::New("Internal error. Formatter has to be specified.")));
     return;
-  } else {
-    millis = v8::Date::Cast(*args[1])->NumberValue();
   }
 
   icu::SimpleDateFormat* date_format = UnpackDateFormat(args[0]->ToObject());
@@ -83,6 +97,30 @@ void DateFormat::JSInternalFormat(
     return;
   }
 
+  // Date value is optional, current time is formatted if it's undefined.
+  double millis = 0.0;
+  if (args.Length() < 2 || args[1]->IsUndefined()) {
+    millis = icu::Calendar::getNow();
+  } else {
+    v8::Local<v8::Number> number = args[1]->ToNumber();
+    if (number.IsEmpty()) {
+      // Exception is pending.
+      return;
+    }
+    millis = number->Value();
+  }
+
+  // NaN and infinities fail the comparison too. Date constructor would
+  // turn out of range values into an invalid date.
+  if (!(fabs(millis) <= kMaxTimeInMs)) {
+    v8::ThrowException(v8::Exception::RangeError(
+        v8::String::New("Provided date is not in valid range.")));
+    return;
+  }
+
+  // TimeClip, as done by the Date constructor.
+  millis = (millis < 0) ? ceil(millis) : floor(millis);
+
   icu::UnicodeString result;
   date_format->format(millis, result);
 
@@ -124,7 +162,7 @@ void DateFormat::JSInternalParse(
 void DateFormat::JSCreateDateTimeFormat(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
   if (args.Length() != 3 ||
-      !args[0]->IsString() ||
+      !args[0]->IsArray() ||
       !args[1]->IsObject() ||
       !args[2]->IsObject()) {
     v8::ThrowException(v8::Exception::Error(
@@ -132,6 +170,15 @@ void DateFormat::JSCreateDateTimeFormat(
     return;
   }
 
+  std::string requested_locale;
+  DateFormatOptions options;
+  if (!ResolveDateFormatOptions(v8::Local<v8::Array>::Cast(args[0]),
+                                args[1]->ToObject(),
+                                &requested_locale,
+                                &options)) {
+    return;
+  }
+
   v8::Isolate* isolate = args.GetIsolate();
   v8::Local<v8::ObjectTemplate> date_format_template =
       Utils::GetTemplate(isolate);
@@ -146,25 +193,34 @@ void DateFormat::JSCreateDateTimeFormat(
   }
 
   // Set date time formatter as internal field of the resulting JS object.
-  icu::SimpleDateFormat* date_format = InitializeDateTimeFormat(
-      args[0]->ToString(), args[1]->ToObject(), args[2]->ToObject());
+  v8::Local<v8::Object> resolved = args[2]->ToObject();
+  icu::SimpleDateFormat* date_format =
+      InitializeDateTimeFormat(requested_locale, options, resolved);
 
   if (!date_format) {
     v8::ThrowException(v8::Exception::Error(v8::String::New(
         "Internal error. Couldn't create ICU date time formatter.")));
     return;
-  } else {
-    local_object->SetAlignedPointerInInternalField(0, date_format);
+  }
 
-    v8::TryCatch try_catch;
-    local_object->Set(v8::String::New("dateFormat"), v8::String::New("valid"));
-    if (try_catch.HasCaught()) {
-      v8::ThrowException(v8::Exception::Error(
-          v8::String::New("Internal error, couldn't set property.")));
+  // ICU falls back to GMT for time zones it doesn't know.
+  if (!options.time_zone.empty()) {
+    v8::String::Utf8Value resolved_time_zone(
+        resolved->Get(PropertyNames::Get(PropertyNames::TIME_ZONE)));
+    if (*resolved_time_zone == NULL ||
+        options.time_zone != *resolved_time_zone) {
+      delete date_format;
+      v8::ThrowException(v8::Exception::RangeError(v8::String::Concat(
+          v8::String::New("Unsupported time zone specified "),
+          v8::String::New(options.time_zone.c_str()))));
       return;
     }
   }
 
+  local_object->SetAlignedPointerInInternalField(0, date_format);
+
+  Utils::SetWrapperType(local_object, Utils::DATE_FORMAT_WRAPPER);
+
   v8::Persistent<v8::Object> wrapper(isolate, local_object);
   // Make object handle weak so we can delete iterator once GC kicks in.
   wrapper.MakeWeak<void>(NULL, &DeleteDateFormat);
@@ -172,18 +228,206 @@ void DateFormat::JSCreateDateTimeFormat(
   wrapper.ClearAndLeak();
 }
 
+// Returns index of |value| in NULL terminated |values|, or -1.
+static int IndexOf(const std::string& value, const char* const* values) {
+  for (int i = 0; values[i]; ++i) {
+    if (value == values[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Returns Area/Location name in canonical case, or UTC for its aliases.
+// Returns false if the name is not a valid IANA name.
+static bool CanonicalizeTimeZoneID(const std::string& id,
+                                   std::string* canonical) {
+  std::string upper(id);
+  for (size_t i = 0; i < upper.length(); ++i) {
+    if (upper[i] >= 'a' && upper[i] <= 'z') {
+      upper[i] -= 'a' - 'A';
+    }
+  }
+
+  // Special case handling (UTC, GMT).
+  if (upper == "UTC" || upper == "GMT" ||
+      upper == "ETC/UTC" || upper == "ETC/GMT") {
+    canonical->assign("UTC");
+    return true;
+  }
+
+  // We expect only _ and / beside ASCII letters, as in Area/Location_Name.
+  // Each word is title cased.
+  canonical->clear();
+  bool slash_seen = false;
+  bool word_start = true;
+  for (size_t i = 0; i < id.length(); ++i) {
+    char c = id[i];
+    if (c == '/' || c == '_') {
+      if (word_start || (c == '/' && slash_seen) || (c == '_' && !slash_seen)) {
+        return false;
+      }
+      slash_seen = true;
+      word_start = true;
+      canonical->push_back(c);
+    } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+      canonical->push_back(
+          word_start ? upper[i] : static_cast<char>(upper[i] + 'a' - 'A'));
+      word_start = false;
+    } else {
+      return false;
+    }
+  }
+
+  return slash_seen && !word_start;
+}
+
+// Reads user options in the order ECMA-402 specifies, resolves the locale,
+// and builds LDML skeleton for the pattern generator.
+// Returns false with an exception pending on invalid options.
+static bool ResolveDateFormatOptions(v8::Handle<v8::Array> requested_locales,
+                                     v8::Handle<v8::Object> user_options,
+                                     std::string* requested_locale,
+                                     DateFormatOptions* options) {
+  static const char* const kTextValues[] = {"narrow", "short", "long", NULL};
+  static const char* const kNumericValues[] = {"2-digit", "numeric", NULL};
+  static const char* const kMonthValues[] = {
+    "2-digit", "numeric", "narrow", "short", "long", NULL
+  };
+  static const char* const kTimeZoneNameValues[] = {"short", "long", NULL};
+  static const char* const kFormatMatcherValues[] = {
+    "basic", "best fit", NULL
+  };
+
+  // Option name, allowed values and matching LDML symbols, in skeleton
+  // order.
+  static const struct {
+    PropertyNames::Name name;
+    const char* const* values;
+    const char* symbols[5];
+  } kFields[] = {
+    {PropertyNames::WEEKDAY, kTextValues, {"EEEEE", "EEE", "EEEE"}},
+    {PropertyNames::ERA, kTextValues, {"GGGGG", "GGG", "GGGG"}},
+    {PropertyNames::YEAR, kNumericValues, {"yy", "y"}},
+    {PropertyNames::MONTH, kMonthValues, {"MM", "M", "MMMMM", "MMM", "MMMM"}},
+    {PropertyNames::DAY, kNumericValues, {"dd", "d"}},
+    // Hour symbols depend on hour12, see below.
+    {PropertyNames::HOUR, kNumericValues, {"jj", "j"}},
+    {PropertyNames::MINUTE, kNumericValues, {"mm", "m"}},
+    {PropertyNames::SECOND, kNumericValues, {"ss", "s"}},
+    {PropertyNames::TIME_ZONE_NAME, kTimeZoneNameValues, {"v", "vv"}}
+  };
+  static const int kFieldCount = sizeof(kFields) / sizeof(kFields[0]);
+  static const int kHourField = 5;
+
+  OptionResolver resolver(user_options, "dateformat");
+  LocaleMatch match;
+  if (!resolver.ResolveLocale("dateformat", requested_locales, &match)) {
+    return false;
+  }
+
+  // Time zone.
+  v8::Local<v8::Value> time_zone;
+  if (!resolver.Get(PropertyNames::TIME_ZONE, &time_zone)) {
+    return false;
+  }
+  if (!time_zone->IsUndefined()) {
+    v8::TryCatch try_catch;
+    v8::Local<v8::String> time_zone_string = time_zone->ToString();
+    if (try_catch.HasCaught()) {
+      try_catch.ReThrow();
+      return false;
+    }
+
+    v8::String::Utf8Value utf8_time_zone(time_zone_string);
+    if (!CanonicalizeTimeZoneID(
+            std::string(*utf8_time_zone, utf8_time_zone.length()),
+            &options->time_zone)) {
+      v8::ThrowException(v8::Exception::RangeError(v8::String::Concat(
+          v8::String::New("Expected Area/Location for time zone, got "),
+          time_zone_string)));
+      return false;
+    }
+  }
+
+  // Date and time fields.
+  int indices[kFieldCount];
+  for (int i = 0; i < kFieldCount; ++i) {
+    std::string value;
+    bool found = false;
+    if (!resolver.GetString(kFields[i].name, kFields[i].values,
+                            &value, &found)) {
+      return false;
+    }
+    indices[i] = found ? IndexOf(value, kFields[i].values) : -1;
+  }
+
+  // We implement only best fit algorithm, but still need to check
+  // if the formatMatcher values are in range.
+  std::string format_matcher;
+  bool found = false;
+  if (!resolver.GetString(PropertyNames::FORMAT_MATCHER, kFormatMatcherValues,
+                          &format_matcher, &found)) {
+    return false;
+  }
+
+  // Without hour12, locale decides between 12 and 24 hour clock.
+  static const char* const kHour12Symbols[] = {"hh", "h"};
+  static const char* const kHour24Symbols[] = {"HH", "H"};
+  const char* const* hour_symbols = kFields[kHourField].symbols;
+  if (indices[kHourField] != -1) {
+    bool hour12 = false;
+    if (!resolver.GetBoolean(PropertyNames::HOUR12, &hour12, &found)) {
+      return false;
+    }
+    if (found) {
+      hour_symbols = hour12 ? kHour12Symbols : kHour24Symbols;
+    }
+  }
+
+  options->skeleton.clear();
+  for (int i = 0; i < kFieldCount; ++i) {
+    if (indices[i] == -1) {
+      continue;
+    }
+    if (i == kHourField) {
+      options->skeleton.append(hour_symbols[indices[i]]);
+    } else {
+      options->skeleton.append(kFields[i].symbols[indices[i]]);
+    }
+  }
+
+  // ICU prefers calendar and numbering system to be passed as -u-
+  // extension keys.
+  requested_locale->assign(match.locale);
+  ExtensionMap extension;
+  OptionResolver::ParseExtension(match.extension, &extension);
+  std::string keys;
+  static const char* const kExtensionKeys[] = {"ca", "nu", NULL};
+  for (int i = 0; kExtensionKeys[i]; ++i) {
+    ExtensionMap::const_iterator it = extension.find(kExtensionKeys[i]);
+    if (it != extension.end() && !it->second.empty()) {
+      keys.append("-").append(it->first).append("-").append(it->second);
+    }
+  }
+  if (!keys.empty()) {
+    requested_locale->append("-u").append(keys);
+  }
+
+  return true;
+}
+
 static icu::SimpleDateFormat* InitializeDateTimeFormat(
-    v8::Handle<v8::String> locale,
-    v8::Handle<v8::Object> options,
+    const std::string& locale,
+    const DateFormatOptions& options,
     v8::Handle<v8::Object> resolved) {
   // Convert BCP47 into ICU locale format.
   UErrorCode status = U_ZERO_ERROR;
   icu::Locale icu_locale;
   char icu_result[ULOC_FULLNAME_CAPACITY];
   int icu_length = 0;
-  v8::String::AsciiValue bcp47_locale(locale);
-  if (bcp47_locale.length() != 0) {
-    uloc_forLanguageTag(*bcp47_locale, icu_result, ULOC_FULLNAME_CAPACITY,
+  if (!locale.empty()) {
+    uloc_forLanguageTag(locale.c_str(), icu_result, ULOC_FULLNAME_CAPACITY,
                         &icu_length, &status);
     if (U_FAILURE(status) || icu_length == 0) {
       return NULL;
@@ -196,6 +440,9 @@ static icu::SimpleDateFormat* InitializeDateTimeFormat(
     // Remove extensions and try again.
     icu::Locale no_extension_locale(icu_locale.getBaseName());
     date_format = CreateICUDateFormat(no_extension_locale, options);
+    if (!date_format) {
+      return NULL;
+    }
 
     // Set resolved settings (pattern, numbering system, calendar).
     SetResolvedSettings(no_extension_locale, date_format, resolved);
@@ -203,17 +450,20 @@ static icu::SimpleDateFormat* InitializeDateTimeFormat(
     SetResolvedSettings(icu_locale, date_format, resolved);
   }
 
+  resolved->Set(PropertyNames::Get(PropertyNames::REQUESTED_LOCALE),
+                v8::String::New(locale.c_str()));
+
   return date_format;
 }
 
 static icu::SimpleDateFormat* CreateICUDateFormat(
-    const icu::Locale& icu_locale, v8::Handle<v8::Object> options) {
+    const icu::Locale& icu_locale, const DateFormatOptions& options) {
   // Create time zone as specified by the user. We have to re-create time zone
   // since calendar takes ownership.
   icu::TimeZone* tz = NULL;
-  icu::UnicodeString timezone;
-  if (Utils::ExtractStringSetting(options, "timeZone", &timezone)) {
-    tz = icu::TimeZone::createTimeZone(timezone);
+  if (!options.time_zone.empty()) {
+    tz = icu::TimeZone::createTimeZone(
+        icu::UnicodeString(options.time_zone.c_str(), -1, US_INV));
   } else {
     tz = icu::TimeZone::createDefault();
   }
@@ -226,20 +476,18 @@ static icu::SimpleDateFormat* CreateICUDateFormat(
   // Make formatter from skeleton. Calendar and numbering system are added
   // to the locale as Unicode extension (if they were specified at all).
   icu::SimpleDateFormat* date_format = NULL;
-  icu::UnicodeString skeleton;
-  if (Utils::ExtractStringSetting(options, "skeleton", &skeleton)) {
-    icu::DateTimePatternGenerator* generator =
-        icu::DateTimePatternGenerator::createInstance(icu_locale, status);
-    icu::UnicodeString pattern;
-    if (U_SUCCESS(status)) {
-      pattern = generator->getBestPattern(skeleton, status);
-      delete generator;
-    }
+  icu::UnicodeString skeleton(options.skeleton.c_str(), -1, US_INV);
+  icu::DateTimePatternGenerator* generator =
+      icu::DateTimePatternGenerator::createInstance(icu_locale, status);
+  icu::UnicodeString pattern;
+  if (U_SUCCESS(status)) {
+    pattern = generator->getBestPattern(skeleton, status);
+    delete generator;
+  }
 
-    date_format = new icu::SimpleDateFormat(pattern, icu_locale, status);
-    if (U_SUCCESS(status)) {
-      date_format->adoptCalendar(calendar);
-    }
+  date_format = new icu::SimpleDateFormat(pattern, icu_locale, status);
+  if (U_SUCCESS(status)) {
+    date_format->adoptCalendar(calendar);
   }
 
   if (U_FAILURE(status)) {
@@ -257,7 +505,7 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
   UErrorCode status = U_ZERO_ERROR;
   icu::UnicodeString pattern;
   date_format->toPattern(pattern);
-  resolved->Set(v8::String::New("pattern"),
+  resolved->Set(PropertyNames::Get(PropertyNames::PATTERN),
                 v8::String::New(reinterpret_cast<const uint16_t*>(
                     pattern.getBuffer()), pattern.length()));
 
@@ -265,7 +513,8 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
   if (date_format) {
     const icu::Calendar* calendar = date_format->getCalendar();
     const char* calendar_name = calendar->getType();
-    resolved->Set(v8::String::New("calendar"), v8::String::New(calendar_name));
+    resolved->Set(PropertyNames::Get(PropertyNames::CALENDAR),
+                  v8::String::New(calendar_name));
 
     const icu::TimeZone& tz = calendar->getTimeZone();
     icu::UnicodeString time_zone;
@@ -275,9 +524,10 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
     icu::TimeZone::getCanonicalID(time_zone, canonical_time_zone, status);
     if (U_SUCCESS(status)) {
       if (canonical_time_zone == UNICODE_STRING_SIMPLE("Etc/GMT")) {
-        resolved->Set(v8::String::New("timeZone"), v8::String::New("UTC"));
+        resolved->Set(PropertyNames::Get(PropertyNames::TIME_ZONE),
+                      v8::String::New("UTC"));
       } else {
-        resolved->Set(v8::String::New("timeZone"),
+        resolved->Set(PropertyNames::Get(PropertyNames::TIME_ZONE),
                       v8::String::New(reinterpret_cast<const uint16_t*>(
                           canonical_time_zone.getBuffer()),
                                       canonical_time_zone.length()));
@@ -293,9 +543,11 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
       icu::NumberingSystem::createInstance(icu_locale, status);
   if (U_SUCCESS(status)) {
     const char* ns = numbering_system->getName();
-    resolved->Set(v8::String::New("numberingSystem"), v8::String::New(ns));
+    resolved->Set(PropertyNames::Get(PropertyNames::NUMBERING_SYSTEM),
+                  v8::String::New(ns));
   } else {
-    resolved->Set(v8::String::New("numberingSystem"), v8::Undefined());
+    resolved->Set(PropertyNames::Get(PropertyNames::NUMBERING_SYSTEM),
+                  v8::Undefined());
   }
   delete numbering_system;
 
@@ -305,10 +557,12 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
   uloc_toLanguageTag(
       icu_locale.getName(), result, ULOC_FULLNAME_CAPACITY, FALSE, &status);
   if (U_SUCCESS(status)) {
-    resolved->Set(v8::String::New("locale"), v8::String::New(result));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New(result));
   } else {
     // This would never happen, since we got the locale from ICU.
-    resolved->Set(v8::String::New("locale"), v8::String::New("und"));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New("und"));
   }
 }
 
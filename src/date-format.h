@@ -41,7 +41,8 @@ class DateFormat {
                                v8::Persistent<v8::Object>* object,
                                void* param);
 
-  // Formats date and returns corresponding string.
+  // Formats date and returns corresponding string. Date value is converted
+  // to a number, and defaults to current time.
   static void JSInternalFormat(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   // Parses date and returns corresponding Date object or undefined if parse
@@ -16,69 +16,6 @@
 // each service. The build system combines them together into one
 // Intl namespace.
 
-/**
- * Returns a string that matches LDML representation of the options object.
- */
-function toLDMLString(options) {
-  var getOption = getGetOption(options, 'dateformat');
-
-  var ldmlString = '';
-
-  var option = getOption('weekday', 'string', ['narrow', 'short', 'long']);
-  ldmlString += appendToLDMLString(
-      option, {narrow: 'EEEEE', short: 'EEE', long: 'EEEE'});
-
-  option = getOption('era', 'string', ['narrow', 'short', 'long']);
-  ldmlString += appendToLDMLString(
-      option, {narrow: 'GGGGG', short: 'GGG', long: 'GGGG'});
-
-  option = getOption('year', 'string', ['2-digit', 'numeric']);
-  ldmlString += appendToLDMLString(option, {'2-digit': 'yy', 'numeric': 'y'});
-
-  option = getOption('month', 'string',
-                     ['2-digit', 'numeric', 'narrow', 'short', 'long']);
-  ldmlString += appendToLDMLString(option, {'2-digit': 'MM', 'numeric': 'M',
-          'narrow': 'MMMMM', 'short': 'MMM', 'long': 'MMMM'});
-
-  option = getOption('day', 'string', ['2-digit', 'numeric']);
-  ldmlString += appendToLDMLString(
-      option, {'2-digit': 'dd', 'numeric': 'd'});
-
-  var hr12 = getOption('hour12', 'boolean');
-  option = getOption('hour', 'string', ['2-digit', 'numeric']);
-  if (hr12 === undefined) {
-    ldmlString += appendToLDMLString(option, {'2-digit': 'jj', 'numeric': 'j'});
-  } else if (hr12 === true) {
-    ldmlString += appendToLDMLString(option, {'2-digit': 'hh', 'numeric': 'h'});
-  } else {
-    ldmlString += appendToLDMLString(option, {'2-digit': 'HH', 'numeric': 'H'});
-  }
-
-  option = getOption('minute', 'string', ['2-digit', 'numeric']);
-  ldmlString += appendToLDMLString(option, {'2-digit': 'mm', 'numeric': 'm'});
-
-  option = getOption('second', 'string', ['2-digit', 'numeric']);
-  ldmlString += appendToLDMLString(option, {'2-digit': 'ss', 'numeric': 's'});
-
-  option = getOption('timeZoneName', 'string', ['short', 'long']);
-  ldmlString += appendToLDMLString(option, {short: 'v', long: 'vv'});
-
-  return ldmlString;
-}
-
-
-/**
- * Returns either LDML equivalent of the current option or empty string.
- */
-function appendToLDMLString(option, pairs) {
-  if (option !== undefined) {
-    return pairs[option];
-  } else {
-    return '';
-  }
-}
-
-
 /**
  * Returns object that matches LDML representation of the date.
  */
@@ -227,37 +164,10 @@ function initializeDateTimeFormat(dateFormat, locales, options) {
     throw new TypeError('Trying to re-initialize DateTimeFormat object.');
   }
 
-  if (options === undefined) {
-    options = {};
-  }
-
-  var locale = resolveLocale('dateformat', locales, options);
+  var requestedLocales = initializeLocaleList(locales);
 
   options = toDateTimeOptions(options, 'any', 'date');
 
-  var getOption = getGetOption(options, 'dateformat');
-
-  // We implement only best fit algorithm, but still need to check
-  // if the formatMatcher values are in range.
-  var matcher = getOption('formatMatcher', 'string',
-                          ['basic', 'best fit'], 'best fit');
-
-  // Build LDML string for the skeleton that we pass to the formatter.
-  var ldmlString = toLDMLString(options);
-
-  // Filter out supported extension keys so we know what to put in resolved
-  // section later on.
-  // We need to pass calendar and number system to the method.
-  var tz = canonicalizeTimeZoneID(options.timeZone);
-
-  // ICU prefers options to be passed using -u- extension key/values, so
-  // we need to build that.
-  var internalOptions = {};
-  var extensionMap = parseExtension(locale.extension);
-  var extension = setOptions(options, extensionMap, DATETIME_FORMAT_KEY_MAP,
-                             getOption, internalOptions);
-
-  var requestedLocale = locale.locale + extension;
   var resolved = Object.defineProperties({}, {
     calendar: {writable: true},
     day: {writable: true},
@@ -269,21 +179,17 @@ function initializeDateTimeFormat(dateFormat, locales, options) {
     month: {writable: true},
     numberingSystem: {writable: true},
     pattern: {writable: true},
-    requestedLocale: {value: requestedLocale, writable: true},
+    requestedLocale: {writable: true},
     second: {writable: true},
     timeZone: {writable: true},
     timeZoneName: {writable: true},
-    tz: {value: tz, writable: true},
     weekday: {writable: true},
     year: {writable: true}
   });
 
-  var formatter = NativeJSCreateDateTimeFormat(
-    requestedLocale, {skeleton: ldmlString, timeZone: tz}, resolved);
-
-  if (tz !== undefined && tz !== resolved.timeZone) {
-    throw new RangeError('Unsupported time zone specified ' + tz);
-  }
+  // Skeleton and time zone are resolved natively, together with the locale.
+  var formatter =
+      NativeJSCreateDateTimeFormat(requestedLocales, options, resolved);
 
   Object.defineProperty(dateFormat, 'formatter', {value: formatter});
   Object.defineProperty(dateFormat, 'resolved', {value: resolved});
@@ -390,20 +296,7 @@ function initializeDateTimeFormat(dateFormat, locales, options) {
  * DateTimeFormat.
  */
 function formatDate(formatter, dateValue) {
-  native function NativeJSInternalDateFormat();
-
-  var dateMs;
-  if (dateValue === undefined) {
-    dateMs = Date.now();
-  } else {
-    dateMs = Number(dateValue);
-  }
-
-  if (!isFinite(dateMs)) {
-    throw new RangeError('Provided date is not in valid range.');
-  }
-
-  return NativeJSInternalDateFormat(formatter.formatter, new Date(dateMs));
+  return NativeJSInternalDateFormat(formatter.formatter, dateValue);
 }
 
 
@@ -419,41 +312,19 @@ function parseDate(formatter, value) {
 }
 
 
-// 0 because date is optional argument.
-addBoundMethod(Intl.DateTimeFormat, 'format', formatDate, 0);
-addBoundMethod(Intl.DateTimeFormat, 'v8Parse', parseDate, 1);
-
+// Formats current time if dateValue is undefined, and throws RangeError if
+// dateValue isn't a finite number.
+native function NativeJSInternalDateFormat();
 
-/**
- * Returns canonical Area/Location name, or throws an exception if the zone
- * name is invalid IANA name.
- */
-function canonicalizeTimeZoneID(tzID) {
-  // Skip undefined zones.
-  if (tzID === undefined) {
-    return tzID;
-  }
-
-  // Special case handling (UTC, GMT).
-  var upperID = tzID.toUpperCase();
-  if (upperID === 'UTC' || upperID === 'GMT' ||
-      upperID === 'ETC/UTC' || upperID === 'ETC/GMT') {
-    return 'UTC';
-  }
 
-  // We expect only _ and / beside ASCII letters.
-  // All inputs should conform to Area/Location from now on.
-  var match = TIMEZONE_NAME_CHECK_RE.exec(tzID);
-  if (match === null) {
-    throw new RangeError('Expected Area/Location for time zone, got ' + tzID);
-  }
+// 0 because date is optional argument.
+addBoundMethod(Intl.DateTimeFormat, 'format', NativeJSInternalDateFormat, 0,
+               'formatter');
+addBoundMethod(Intl.DateTimeFormat, 'v8Parse', parseDate, 1);
 
-  var result = toTitleCaseWord(match[1]) + '/' + toTitleCaseWord(match[2]);
-  var i = 3;
-  while (match[i] !== undefined && i < match.length) {
-    result = result + '_' + toTitleCaseWord(match[i]);
-    i++;
-  }
 
-  return result;
-}
+exportService('date-format', {
+  constructor: Intl.DateTimeFormat,
+  formatDate: formatDate,
+  toDateTimeOptions: toDateTimeOptions
+});
@@ -14,9 +14,11 @@
 
 #include "include/extension.h"
 
+#include "src/break-iterator-pool.h"
 #include "src/break-iterator.h"
 #include "src/collator.h"
 #include "src/date-format.h"
+#include "src/isolate-data.h"
 #include "src/locale.h"
 #include "src/natives.h"
 #include "src/number-format.h"
@@ -25,8 +27,14 @@ namespace v8_i18n {
 
 Extension* Extension::extension_ = NULL;
 
+// Passing the length saves V8 a strlen of the whole source per isolate.
 Extension::Extension()
-    : v8::Extension("v8/i18n", Natives::GetScriptSource()) {
+    : v8::Extension("v8/i18n",
+                    Natives::GetScriptSource(),
+                    0,
+                    NULL,
+                    Natives::GetScriptSourceLength()) {
+  IsolateData::Initialize();
 }
 
 v8::Handle<v8::FunctionTemplate> Extension::GetNativeFunction(
@@ -34,12 +42,20 @@ v8::Handle<v8::FunctionTemplate> Extension::GetNativeFunction(
   // Standalone, helper methods.
   if (name->Equals(v8::String::New("NativeJSCanonicalizeLanguageTag"))) {
     return v8::FunctionTemplate::New(JSCanonicalizeLanguageTag);
-  } else if (name->Equals(v8::String::New("NativeJSAvailableLocalesOf"))) {
-    return v8::FunctionTemplate::New(JSAvailableLocalesOf);
-  } else if (name->Equals(v8::String::New("NativeJSGetDefaultICULocale"))) {
-    return v8::FunctionTemplate::New(JSGetDefaultICULocale);
-  } else if (name->Equals(v8::String::New("NativeJSGetLanguageTagVariants"))) {
-    return v8::FunctionTemplate::New(JSGetLanguageTagVariants);
+  } else if (name->Equals(v8::String::New("NativeJSLookupMatcher"))) {
+    return v8::FunctionTemplate::New(JSLookupMatcher);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSLookupSupportedLocalesOf"))) {
+    return v8::FunctionTemplate::New(JSLookupSupportedLocalesOf);
+  } else if (name->Equals(v8::String::New("NativeJSBestFitMatcher"))) {
+    return v8::FunctionTemplate::New(JSBestFitMatcher);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBestFitSupportedLocalesOf"))) {
+    return v8::FunctionTemplate::New(JSBestFitSupportedLocalesOf);
+  } else if (name->Equals(v8::String::New("NativeJSMatchAcceptLanguage"))) {
+    return v8::FunctionTemplate::New(JSMatchAcceptLanguage);
+  } else if (name->Equals(v8::String::New("NativeJSGetOptimalLanguageTag"))) {
+    return v8::FunctionTemplate::New(JSGetOptimalLanguageTag);
   }
 
   // Date format and parse.
@@ -65,6 +81,9 @@ v8::Handle<v8::FunctionTemplate> Extension::GetNativeFunction(
     return v8::FunctionTemplate::New(Collator::JSCreateCollator);
   } else if (name->Equals(v8::String::New("NativeJSInternalCompare"))) {
     return v8::FunctionTemplate::New(Collator::JSInternalCompare);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSInternalCollatorBinaryRules"))) {
+    return v8::FunctionTemplate::New(Collator::JSInternalBinaryRules);
   }
 
   // Break iterator.
@@ -85,6 +104,40 @@ v8::Handle<v8::FunctionTemplate> Extension::GetNativeFunction(
   } else if (name->Equals(v8::String::New("NativeJSBreakIteratorBreakType"))) {
     return v8::FunctionTemplate::New(
 	BreakIterator::JSInternalBreakIteratorBreakType);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBreakIteratorBoundaries"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorBoundaries);
+  } else if (name->Equals(v8::String::New("NativeJSBreakIteratorTokens"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorTokens);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBreakIteratorSegmentCount"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorSegmentCount);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBreakIteratorSegmentOffset"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorSegmentOffset);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBreakIteratorPrecedingBoundary"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorPrecedingBoundary);
+  } else if (name->Equals(v8::String::New("NativeJSBreakIteratorWrap"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorWrap);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBreakIteratorSegmentChunk"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorSegmentChunk);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBreakIteratorBinaryRules"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorBinaryRules);
+  } else if (name->Equals(
+                 v8::String::New("NativeJSBreakIteratorCacheStats"))) {
+    return v8::FunctionTemplate::New(
+        BreakIterator::JSInternalBreakIteratorCacheStats);
   }
 
   return v8::Handle<v8::FunctionTemplate>();
@@ -97,6 +150,30 @@ Extension* Extension::get() {
   return extension_;
 }
 
+void Extension::SetIsolateDataSlot(uint32_t slot) {
+  IsolateData::SetSlot(slot);
+}
+
+void Extension::DisposeIsolateData(v8::Isolate* isolate) {
+  IsolateData::Dispose(isolate);
+}
+
+void Extension::SetBreakIteratorPoolLimit(int limit) {
+  BreakIteratorPool::SetLimit(limit);
+}
+
+void Extension::SetBreakIteratorCacheSize(int size) {
+  BreakIteratorPool::SetCacheSize(size);
+}
+
+bool Extension::RegisterBreakRules(const uint8_t* data, size_t length) {
+  return BreakIteratorPool::RegisterBinaryRules(data, length);
+}
+
+bool Extension::RegisterCollatorRules(const uint8_t* data, size_t length) {
+  return Collator::RegisterBinaryRules(data, length);
+}
+
 void Extension::Register() {
   static v8::DeclareExtension extension_declaration(Extension::get());
 }
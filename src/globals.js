@@ -21,31 +21,6 @@ var AVAILABLE_SERVICES = ['collator',
 			  'dateformat',
 			  'breakiterator'];
 
-/**
- * Caches available locales for each service.
- */
-var AVAILABLE_LOCALES = {
-  'collator': undefined,
-  'numberformat': undefined,
-  'dateformat': undefined,
-  'breakiterator': undefined
-};
-
-/**
- * Caches default ICU locale.
- */
-var DEFAULT_ICU_LOCALE = undefined;
-
-/**
- * Unicode extension regular expression.
- */
-var UNICODE_EXTENSION_RE = new RegExp('-u(-[a-z0-9]{2,8})+', 'g');
-
-/**
- * Matches any Unicode extension.
- */
-var ANY_EXTENSION_RE = new RegExp('-[a-z0-9]{1}-.*', 'g');
-
 /**
  * Replace quoted text (single quote, anything but the quote and quote again).
  */
@@ -57,28 +32,6 @@ var QUOTED_STRING_RE = new RegExp("'[^']+'", 'g');
 var SERVICE_RE =
     new RegExp('^(collator|numberformat|dateformat|breakiterator)$');
 
-/**
- * Validates a language tag against bcp47 spec.
- * Actual value is assigned on first run.
- */
-var LANGUAGE_TAG_RE = undefined;
-
-/**
- * Helps find duplicate variants in the language tag.
- */
-var LANGUAGE_VARIANT_RE = undefined;
-
-/**
- * Helps find duplicate singletons in the language tag.
- */
-var LANGUAGE_SINGLETON_RE = undefined;
-
-/**
- * Matches valid IANA time zone names.
- */
-var TIMEZONE_NAME_CHECK_RE =
-    new RegExp('^([A-Za-z]+)/([A-Za-z]+)(?:_([A-Za-z]+))*$');
-
 /**
  * Maps ICU calendar names into LDML type.
  */
@@ -99,40 +52,10 @@ var ICU_CALENDAR_MAP = {
 };
 
 /**
- * Map of Unicode extensions to option properties, and their values and types,
- * for a collator.
- */
-var COLLATOR_KEY_MAP = {
-  'kn': {'property': 'numeric', 'type': 'boolean'},
-  'kf': {'property': 'caseFirst', 'type': 'string',
-         'values': ['false', 'lower', 'upper']}
-};
-
-/**
- * Map of Unicode extensions to option properties, and their values and types,
- * for a number format.
- */
-var NUMBER_FORMAT_KEY_MAP = {
-  'nu': {'property': undefined, 'type': 'string'}
-};
-
-/**
- * Map of Unicode extensions to option properties, and their values and types,
- * for a date/time format.
+ * Break types, indexed by the numeric codes that bulk break iterator methods
+ * return. Keep in sync with BreakType enum in break-iterator.cc.
  */
-var DATETIME_FORMAT_KEY_MAP = {
-  'ca': {'property': undefined, 'type': 'string'},
-  'nu': {'property': undefined, 'type': 'string'}
-};
-
-/**
- * Allowed -u-co- values. List taken from:
- * http://unicode.org/repos/cldr/trunk/common/bcp47/collation.xml
- */
-var ALLOWED_CO_VALUES = [
-  'big5han', 'dict', 'direct', 'ducet', 'gb2312', 'phonebk', 'phonetic',
-  'pinyin', 'reformed', 'searchjl', 'stroke', 'trad', 'unihan', 'zhuyin'
-];
+var BREAK_TYPES = ['none', 'number', 'letter', 'kana', 'ideo', 'unknown'];
 
 /**
  * Object attributes (configurable, writable, enumerable).
@@ -146,6 +69,22 @@ var ATTRIBUTES = {
   'DONT_DELETE': 4
 };
 
+/**
+ * Intl properties of the services that get installed on first use, keyed by
+ * service source file name. See addLazyService.
+ */
+var LAZY_SERVICE_PROPERTIES = {
+  'collator': 'Collator',
+  'number-format': 'NumberFormat',
+  'date-format': 'DateTimeFormat',
+  'break-iterator': 'v8BreakIterator'
+};
+
+/**
+ * Lazy services, with their installers and, once installed, exports.
+ */
+var lazyServices = {};
+
 /**
  * Error message for when function object is created with new and it's not
  * a constructor.
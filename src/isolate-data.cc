@@ -0,0 +1,75 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/isolate-data.h"
+
+namespace v8_i18n {
+
+uint32_t IsolateData::slot_ = 0;
+bool IsolateData::slot_set_ = false;
+
+IsolateData::IsolateData() {
+  for (int i = 0; i < KEY_COUNT; ++i) {
+    values_[i] = NULL;
+    deleters_[i] = NULL;
+  }
+}
+
+// static
+IsolateData* IsolateData::Get(v8::Isolate* isolate) {
+  IsolateData* data = static_cast<IsolateData*>(isolate->GetData(slot_));
+  if (!data) {
+    data = new IsolateData();
+    isolate->SetData(slot_, data);
+  }
+  return data;
+}
+
+// static
+void IsolateData::Dispose(v8::Isolate* isolate) {
+  IsolateData* data = static_cast<IsolateData*>(isolate->GetData(slot_));
+  if (!data) {
+    return;
+  }
+
+  for (int i = 0; i < KEY_COUNT; ++i) {
+    if (data->values_[i]) {
+      data->deleters_[i](isolate, data->values_[i]);
+    }
+  }
+
+  isolate->SetData(slot_, NULL);
+  delete data;
+}
+
+// static
+void IsolateData::Initialize() {
+  // Embedders usually take the first slots, so we default to the last one.
+  if (!slot_set_) {
+    SetSlot(v8::Isolate::GetNumberOfDataSlots() - 1);
+  }
+}
+
+// static
+void IsolateData::SetSlot(uint32_t slot) {
+  slot_ = slot;
+  slot_set_ = true;
+}
+
+void IsolateData::Set(Key key, void* value, Deleter deleter) {
+  values_[key] = value;
+  deleters_[key] = deleter;
+}
+
+}  // namespace v8_i18n
@@ -0,0 +1,100 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef V8_I18N_SRC_ISOLATE_DATA_H_
+#define V8_I18N_SRC_ISOLATE_DATA_H_
+
+#include "v8/include/v8.h"
+
+namespace v8_i18n {
+
+// Caches and templates of one isolate. Isolates may run on different
+// threads at the same time, so nothing the extension creates lazily is
+// kept in process wide statics. The data hangs off an isolate data slot,
+// and is deleted by Extension::DisposeIsolateData.
+class IsolateData {
+ public:
+  enum Key {
+    BREAK_ITERATOR_POOLS = 0,
+    COMPILED_COLLATORS,
+    DEFAULT_LOCALE,
+    ICU_LOCALE_NAMES,
+    LANGUAGE_TAGS,
+    LOCALE_MATCHERS,
+    OPTIMAL_LANGUAGE_TAGS,
+    PROPERTY_NAMES,
+    WRAPPER_TEMPLATES,
+    KEY_COUNT
+  };
+
+  // Deletes a value stored under a key. Called while the isolate is still
+  // entered, so persistent handles can be disposed.
+  typedef void (*Deleter)(v8::Isolate* isolate, void* value);
+
+  // Returns data of the isolate, creating it on first use.
+  static IsolateData* Get(v8::Isolate* isolate);
+
+  // Returns data of the current isolate.
+  static IsolateData* Current() { return Get(v8::Isolate::GetCurrent()); }
+
+  // Deletes data of the isolate, and all values stored in it.
+  static void Dispose(v8::Isolate* isolate);
+
+  // Picks the default slot, unless the embedder set one. Called when the
+  // extension is created, before any isolate can run its code.
+  static void Initialize();
+
+  // Sets the isolate data slot used by the extension. Defaults to the last
+  // slot. Has to be called before any isolate runs extension code.
+  static void SetSlot(uint32_t slot);
+
+  // Returns the value stored under the key, or NULL.
+  void* Get(Key key) const { return values_[key]; }
+
+  // Stores the value under the key. |deleter| is called on it when the
+  // isolate data is disposed. The key must not be set yet. JS wrappers may
+  // outlive the data, so anything they point to has to be reference
+  // counted, and the deleter only drops the data's references.
+  void Set(Key key, void* value, Deleter deleter);
+
+  // Returns the value stored under the key, default constructing it on
+  // first use. For values that own nothing but themselves.
+  template <class T>
+  T* GetOrCreate(Key key) {
+    T* value = static_cast<T*>(Get(key));
+    if (!value) {
+      value = new T();
+      Set(key, value, &Delete<T>);
+    }
+    return value;
+  }
+
+ private:
+  IsolateData();
+
+  template <class T>
+  static void Delete(v8::Isolate* isolate, void* value) {
+    delete static_cast<T*>(value);
+  }
+
+  void* values_[KEY_COUNT];
+  Deleter deleters_[KEY_COUNT];
+
+  static uint32_t slot_;
+  static bool slot_set_;
+};
+
+}  // namespace v8_i18n
+
+#endif  // V8_I18N_SRC_ISOLATE_DATA_H_
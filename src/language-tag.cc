@@ -0,0 +1,240 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/language-tag.h"
+
+#include <map>
+#include <vector>
+
+#include "src/isolate-data.h"
+#include "src/lru-cache.h"
+#include "unicode/uloc.h"
+
+namespace v8_i18n {
+
+// Canonicalized tags, keyed by the tag as given.
+static const size_t kMaxCachedTags = 1024;
+typedef LruCache<std::string, kMaxCachedTags> TagCache;
+
+// Grandfathered tags, from section 2.1 of BCP47.
+static const char* const kGrandfatheredTags[] = {
+  // Irregular.
+  "en-gb-oed", "i-ami", "i-bnn", "i-default", "i-enochian", "i-hak",
+  "i-klingon", "i-lux", "i-mingo", "i-navajo", "i-pwn", "i-tao", "i-tay",
+  "i-tsu", "sgn-be-fr", "sgn-be-nl", "sgn-ch-de",
+  // Regular.
+  "art-lojban", "cel-gaulish", "no-bok", "no-nyn", "zh-guoyu", "zh-hakka",
+  "zh-min", "zh-min-nan", "zh-xiang"
+};
+
+static bool IsAlpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static char ToLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Returns true if the subtag is |min| to |max| letters long.
+static bool IsAlphaSubtag(const std::string& subtag, size_t min, size_t max) {
+  if (subtag.length() < min || subtag.length() > max) {
+    return false;
+  }
+  for (size_t i = 0; i < subtag.length(); ++i) {
+    if (!IsAlpha(subtag[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Region is 2 letters or 3 digits.
+static bool IsRegion(const std::string& subtag) {
+  if (subtag.length() == 2) {
+    return IsAlpha(subtag[0]) && IsAlpha(subtag[1]);
+  }
+  return subtag.length() == 3 && IsDigit(subtag[0]) && IsDigit(subtag[1]) &&
+         IsDigit(subtag[2]);
+}
+
+// Variant is 5 to 8 alphanumerics, or a digit and 3 alphanumerics.
+static bool IsVariant(const std::string& subtag) {
+  return subtag.length() >= 5 || (subtag.length() == 4 && IsDigit(subtag[0]));
+}
+
+static std::string ToLowerString(const std::string& value) {
+  std::string result(value);
+  for (size_t i = 0; i < result.length(); ++i) {
+    result[i] = ToLower(result[i]);
+  }
+  return result;
+}
+
+// Splits the tag into subtags. Returns false if a subtag is empty, longer
+// than 8 characters or has anything but ASCII letters and digits.
+static bool SplitSubtags(const std::string& tag,
+                         std::vector<std::string>* subtags) {
+  size_t start = 0;
+  while (true) {
+    size_t end = tag.find('-', start);
+    if (end == std::string::npos) {
+      end = tag.length();
+    }
+    if (end == start || end - start > 8) {
+      return false;
+    }
+    for (size_t i = start; i < end; ++i) {
+      if (!IsAlpha(tag[i]) && !IsDigit(tag[i])) {
+        return false;
+      }
+    }
+    subtags->push_back(tag.substr(start, end - start));
+    if (end == tag.length()) {
+      return true;
+    }
+    start = end + 1;
+  }
+}
+
+// static
+bool LanguageTag::IsValid(const std::string& tag) {
+  std::vector<std::string> subtags;
+  if (!SplitSubtags(tag, &subtags)) {
+    return false;
+  }
+
+  std::string lower_tag = ToLowerString(tag);
+  for (size_t i = 0;
+       i < sizeof(kGrandfatheredTags) / sizeof(kGrandfatheredTags[0]); ++i) {
+    if (lower_tag == kGrandfatheredTags[i]) {
+      return true;
+    }
+  }
+
+  size_t count = subtags.size();
+  size_t i = 0;
+
+  // Language, unless the whole tag is private use.
+  if (ToLower(subtags[0][0]) != 'x' || subtags[0].length() != 1) {
+    if (!IsAlphaSubtag(subtags[0], 2, 8)) {
+      return false;
+    }
+    ++i;
+
+    // Up to three extended language subtags after a short language.
+    if (subtags[0].length() <= 3) {
+      for (int extlang = 0;
+           extlang < 3 && i < count && IsAlphaSubtag(subtags[i], 3, 3);
+           ++extlang) {
+        ++i;
+      }
+    }
+
+    if (i < count && IsAlphaSubtag(subtags[i], 4, 4)) {
+      ++i;
+    }
+
+    if (i < count && IsRegion(subtags[i])) {
+      ++i;
+    }
+
+    std::vector<std::string> variants;
+    for (; i < count && IsVariant(subtags[i]); ++i) {
+      std::string variant = ToLowerString(subtags[i]);
+      for (size_t j = 0; j < variants.size(); ++j) {
+        if (variants[j] == variant) {
+          return false;
+        }
+      }
+      variants.push_back(variant);
+    }
+
+    // Extensions, each singleton at most once.
+    std::string singletons;
+    while (i < count && subtags[i].length() == 1 &&
+           ToLower(subtags[i][0]) != 'x') {
+      char singleton = ToLower(subtags[i][0]);
+      if (singletons.find(singleton) != std::string::npos) {
+        return false;
+      }
+      singletons.push_back(singleton);
+      ++i;
+
+      size_t start = i;
+      while (i < count && subtags[i].length() >= 2) {
+        ++i;
+      }
+      if (i == start) {
+        return false;
+      }
+    }
+
+    if (i == count) {
+      return true;
+    }
+    if (subtags[i].length() != 1 || ToLower(subtags[i][0]) != 'x') {
+      return false;
+    }
+  }
+
+  // Private use needs at least one subtag after x. Any length from 1 to 8
+  // is fine, and that was checked by the split.
+  return i + 1 < count;
+}
+
+// static
+bool LanguageTag::Canonicalize(const std::string& tag,
+                               std::string* canonical) {
+  TagCache* cache =
+      IsolateData::Current()->GetOrCreate<TagCache>(IsolateData::LANGUAGE_TAGS);
+
+  std::string* cached = cache->Find(tag);
+  if (cached) {
+    *canonical = *cached;
+    return !canonical->empty();
+  }
+
+  // Invalid tags are cached as empty strings.
+  std::string& result = *cache->Insert(tag, NULL);
+  if (!IsValid(tag) || tag.length() >= ULOC_FULLNAME_CAPACITY) {
+    return false;
+  }
+
+  UErrorCode error = U_ZERO_ERROR;
+  char icu_result[ULOC_FULLNAME_CAPACITY];
+  int icu_length = 0;
+  uloc_forLanguageTag(tag.c_str(), icu_result, ULOC_FULLNAME_CAPACITY,
+                      &icu_length, &error);
+  if (U_FAILURE(error) || icu_length == 0) {
+    return false;
+  }
+
+  // Force strict BCP47 rules.
+  char bcp47_result[ULOC_FULLNAME_CAPACITY];
+  uloc_toLanguageTag(icu_result, bcp47_result, ULOC_FULLNAME_CAPACITY, TRUE,
+                     &error);
+  if (U_FAILURE(error)) {
+    return false;
+  }
+
+  result = bcp47_result;
+  *canonical = result;
+  return true;
+}
+
+}  // namespace v8_i18n
@@ -0,0 +1,41 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef V8_I18N_SRC_LANGUAGE_TAG_H_
+#define V8_I18N_SRC_LANGUAGE_TAG_H_
+
+#include <string>
+
+namespace v8_i18n {
+
+class LanguageTag {
+ public:
+  // Returns true if the tag is well formed according to section 2.1 of
+  // BCP47 (grandfathered tags included), and has no duplicate variants or
+  // singletons (section 2.2.9).
+  // ICU is too permissive and lets invalid tags, like hant-cmn-cn, through.
+  static bool IsValid(const std::string& tag);
+
+  // Validates the tag and canonicalizes it using ICU and strict BCP47
+  // rules. Returns false if the tag is invalid.
+  // Results are cached, so repeated tags cost a single lookup.
+  static bool Canonicalize(const std::string& tag, std::string* canonical);
+
+ private:
+  LanguageTag() {}
+};
+
+}  // namespace v8_i18n
+
+#endif  // V8_I18N_SRC_LANGUAGE_TAG_H_
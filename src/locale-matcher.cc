@@ -0,0 +1,603 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/locale-matcher.h"
+
+#include <algorithm>
+#include <set>
+
+#include "src/isolate-data.h"
+#include "src/language-tag.h"
+#include "unicode/brkiter.h"
+#include "unicode/coll.h"
+#include "unicode/datefmt.h"
+#include "unicode/locid.h"
+#include "unicode/numfmt.h"
+#include "unicode/uloc.h"
+
+namespace v8_i18n {
+
+typedef std::map<std::string, LocaleMatcher*> MatcherMap;
+typedef std::map<std::string, std::string> NameMap;
+
+// Languages with more than one code in use. The second is the one ICU
+// data uses.
+static const char* const kEquivalentLanguages[][2] = {
+  {"iw", "he"},
+  {"in", "id"},
+  {"no", "nb"},
+  {"tl", "fil"}
+};
+
+// Regions that share conventions with a main region of the language, so a
+// request for one of them prefers the main region over other regions.
+// Regions are space separated, main region comes first.
+static const char* const kRegionGroups[][2] = {
+  {"en", "GB AU BE BW BZ HK IE IN JM MT NZ PK SG ZA ZW"},
+  {"es", "419 AR BO CL CO CR CU DO EC GT HN MX NI PA PE PR PY SV US UY VE"},
+  {"pt", "PT AO CV GW MO MZ ST TL"}
+};
+
+// Language range from Accept-Language header, with its quality in
+// thousandths.
+struct WeightedLanguage {
+  int quality;
+  std::string tag;
+};
+
+static bool IsLanguageScriptRegion(const std::string&, size_t*, size_t*);
+static bool ToLanguageTag(const char*, std::string*);
+static void ParseAcceptLanguage(const std::string&,
+                                std::vector<WeightedLanguage>*);
+static int ParseQuality(const std::string&);
+static bool CompareQuality(const WeightedLanguage&, const WeightedLanguage&);
+static std::string Trim(const std::string&);
+static bool MaximizeTag(const std::string&, std::string*, std::string*,
+                        std::string*);
+static int GetRegionGroup(const std::string&, const std::string&);
+
+LocaleMatcher::LocaleMatcher(const std::string& service) {
+  const icu::Locale* available_locales = NULL;
+
+  int32_t count = 0;
+  if (service == "collator") {
+    available_locales = icu::Collator::getAvailableLocales(count);
+  } else if (service == "numberformat") {
+    available_locales = icu::NumberFormat::getAvailableLocales(count);
+  } else if (service == "dateformat") {
+    available_locales = icu::DateFormat::getAvailableLocales(count);
+  } else if (service == "breakiterator") {
+    available_locales = icu::BreakIterator::getAvailableLocales(count);
+  }
+
+  available_.reserve(count);
+  std::string tag;
+  for (int32_t i = 0; i < count; ++i) {
+    if (!ToLanguageTag(available_locales[i].getName(), &tag)) {
+      // This shouldn't happen, but lets not break the user.
+      continue;
+    }
+    available_.push_back(tag);
+
+    // ICU has zh-Hant-TW but not zh-TW, so requests for the latter would
+    // fall back to zh. Make xx-ZZ available for each xx-Yyyy-ZZ.
+    size_t script = 0;
+    size_t region = 0;
+    if (IsLanguageScriptRegion(tag, &script, &region)) {
+      available_.push_back(tag.substr(0, script - 1) + tag.substr(region - 1));
+    }
+  }
+
+  std::sort(available_.begin(), available_.end());
+  available_.erase(std::unique(available_.begin(), available_.end()),
+                   available_.end());
+}
+
+static void DeleteMatchers(v8::Isolate* isolate, void* value) {
+  MatcherMap* matchers = static_cast<MatcherMap*>(value);
+  for (MatcherMap::iterator it = matchers->begin(); it != matchers->end();
+       ++it) {
+    delete it->second;
+  }
+  delete matchers;
+}
+
+// static
+LocaleMatcher* LocaleMatcher::Get(const std::string& service) {
+  // Matchers live as long as the current isolate's data.
+  IsolateData* data = IsolateData::Current();
+  MatcherMap* matchers =
+      static_cast<MatcherMap*>(data->Get(IsolateData::LOCALE_MATCHERS));
+  if (!matchers) {
+    matchers = new MatcherMap();
+    data->Set(IsolateData::LOCALE_MATCHERS, matchers, &DeleteMatchers);
+  }
+
+  MatcherMap::iterator it = matchers->find(service);
+  if (it != matchers->end()) {
+    return it->second;
+  }
+
+  if (service != "collator" && service != "numberformat" &&
+      service != "dateformat" && service != "breakiterator") {
+    return NULL;
+  }
+
+  LocaleMatcher* matcher = new LocaleMatcher(service);
+  (*matchers)[service] = matcher;
+  return matcher;
+}
+
+bool LocaleMatcher::LookupLocale(const std::string& locale,
+                                 std::string* match) const {
+  std::string candidate(locale);
+  while (true) {
+    if (IsAvailable(candidate)) {
+      *match = candidate;
+      return true;
+    }
+    // Truncate locale if possible.
+    size_t pos = candidate.rfind('-');
+    if (pos == std::string::npos) {
+      return false;
+    }
+    candidate.resize(pos);
+  }
+}
+
+bool LocaleMatcher::IsAvailable(const std::string& locale) const {
+  return std::binary_search(available_.begin(), available_.end(), locale);
+}
+
+const LocaleMatch& LocaleMatcher::Lookup(
+    const std::vector<std::string>& requested) {
+  return Match(requested, &LocaleMatcher::LookupLocaleForMatch, &memo_);
+}
+
+const LocaleMatch& LocaleMatcher::BestFit(
+    const std::vector<std::string>& requested) {
+  return Match(requested, &LocaleMatcher::BestFitLocale, &best_fit_memo_);
+}
+
+bool LocaleMatcher::LookupLocaleForMatch(const std::string& locale,
+                                         std::string* match) {
+  return LookupLocale(locale, match);
+}
+
+const LocaleMatch& LocaleMatcher::Match(
+    const std::vector<std::string>& requested,
+    bool (LocaleMatcher::*match_locale)(const std::string&, std::string*),
+    MatchMap* memo) {
+  std::string key;
+  for (size_t i = 0; i < requested.size(); ++i) {
+    key.append(requested[i]);
+    key.push_back(',');
+  }
+
+  LocaleMatch* cached = memo->Find(key);
+  if (cached) {
+    return *cached;
+  }
+
+  LocaleMatch& result = *memo->Insert(key, NULL);
+  for (size_t i = 0; i < requested.size(); ++i) {
+    if ((this->*match_locale)(RemoveExtensions(requested[i]),
+                              &result.locale)) {
+      RemoveUnicodeExtension(requested[i], &result.extension);
+      result.position = static_cast<int>(i);
+      return result;
+    }
+  }
+
+  // Didn't find a match, return default.
+  result.locale = DefaultLocale();
+  result.extension.clear();
+  result.position = -1;
+  return result;
+}
+
+void LocaleMatcher::LookupSupported(const std::vector<std::string>& requested,
+                                    std::vector<std::string>* supported) const {
+  std::string extension;
+  std::string match;
+  for (size_t i = 0; i < requested.size(); ++i) {
+    if (LookupLocale(RemoveUnicodeExtension(requested[i], &extension),
+                     &match)) {
+      // Push requested locale not the resolved one.
+      supported->push_back(requested[i]);
+    }
+  }
+}
+
+void LocaleMatcher::BestFitSupported(
+    const std::vector<std::string>& requested,
+    std::vector<std::string>* supported) {
+  std::string extension;
+  std::string match;
+  for (size_t i = 0; i < requested.size(); ++i) {
+    if (BestFitLocale(RemoveUnicodeExtension(requested[i], &extension),
+                      &match)) {
+      // Push requested locale not the resolved one.
+      supported->push_back(requested[i]);
+    }
+  }
+}
+
+bool LocaleMatcher::BestFitLocale(const std::string& locale,
+                                  std::string* match) {
+  std::string* cached = best_fit_locales_.Find(locale);
+  if (cached) {
+    *match = *cached;
+    return !match->empty();
+  }
+
+  // Index available locales by language, with their likely subtags.
+  if (candidates_.empty()) {
+    std::vector<std::string>::const_iterator tag;
+    for (tag = available_.begin(); tag != available_.end(); ++tag) {
+      std::string language;
+      Candidate candidate;
+      if (MaximizeTag(*tag, &language, &candidate.script,
+                      &candidate.region)) {
+        candidate.tag = *tag;
+        candidates_[language].push_back(candidate);
+      }
+    }
+  }
+
+  std::string& result = *best_fit_locales_.Insert(locale, NULL);
+
+  // Exact match is always the best.
+  if (IsAvailable(locale)) {
+    result = locale;
+    *match = result;
+    return true;
+  }
+
+  std::string language;
+  std::string script;
+  std::string region;
+  CandidateMap::const_iterator language_candidates = candidates_.end();
+  if (MaximizeTag(locale, &language, &script, &region)) {
+    language_candidates = candidates_.find(language);
+  }
+
+  if (language_candidates != candidates_.end()) {
+    // Different script is not acceptable. Same region is the best, then
+    // a region from the same group, then any region. Shorter, more generic,
+    // tags win ties.
+    const std::vector<Candidate>& candidates = language_candidates->second;
+    int region_group = GetRegionGroup(language, region);
+    int best_distance = 3;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (candidates[i].script != script) {
+        continue;
+      }
+      int distance = 2;
+      if (candidates[i].region == region) {
+        distance = 0;
+      } else if (region_group != -1 &&
+                 GetRegionGroup(language, candidates[i].region) ==
+                     region_group) {
+        distance = 1;
+      }
+      if (distance < best_distance ||
+          (distance == best_distance &&
+           candidates[i].tag.length() < result.length())) {
+        best_distance = distance;
+        result = candidates[i].tag;
+      }
+    }
+  }
+
+  // Nothing in the same script, try lookup.
+  if (result.empty()) {
+    LookupLocale(locale, &result);
+  }
+
+  *match = result;
+  return !result.empty();
+}
+
+const std::string& LocaleMatcher::MatchAcceptLanguage(
+    const std::string& header) {
+  std::string* cached = accept_language_memo_.Find(header);
+  if (cached) {
+    return *cached;
+  }
+
+  std::vector<WeightedLanguage> languages;
+  ParseAcceptLanguage(header, &languages);
+
+  // Invalid and duplicate tags are skipped, instead of failing the whole
+  // header.
+  std::vector<std::string> requested;
+  std::set<std::string> seen;
+  std::string canonical;
+  for (size_t i = 0; i < languages.size(); ++i) {
+    if (LanguageTag::Canonicalize(languages[i].tag, &canonical) &&
+        seen.insert(canonical).second) {
+      requested.push_back(canonical);
+    }
+  }
+
+  const LocaleMatch& match = BestFit(requested);
+  std::string& result = *accept_language_memo_.Insert(header, NULL);
+  result = match.locale + match.extension;
+  return result;
+}
+
+// static
+std::string LocaleMatcher::RemoveExtensions(const std::string& tag) {
+  // Extensions and private use start with the first singleton subtag.
+  size_t start = tag.find('-');
+  while (start != std::string::npos) {
+    size_t end = tag.find('-', start + 1);
+    if (end == start + 2) {
+      return tag.substr(0, start);
+    }
+    start = end;
+  }
+  return tag;
+}
+
+// static
+std::string LocaleMatcher::RemoveUnicodeExtension(const std::string& tag,
+                                                  std::string* extension) {
+  extension->clear();
+
+  size_t start = tag.find("-u-");
+  while (start != std::string::npos) {
+    // Extension is made of 2 to 8 character subtags after the singleton.
+    size_t end = start + 2;
+    while (end < tag.length()) {
+      size_t next = tag.find('-', end + 1);
+      size_t length =
+          (next == std::string::npos ? tag.length() : next) - end - 1;
+      if (length < 2 || length > 8) {
+        break;
+      }
+      end = (next == std::string::npos) ? tag.length() : next;
+    }
+
+    if (end > start + 2) {
+      *extension = tag.substr(start, end - start);
+      return tag.substr(0, start) + tag.substr(end);
+    }
+    start = tag.find("-u-", start + 1);
+  }
+
+  return tag;
+}
+
+// static
+const std::string& LocaleMatcher::DefaultLocale() {
+  std::string* default_locale =
+      IsolateData::Current()->GetOrCreate<std::string>(
+          IsolateData::DEFAULT_LOCALE);
+  if (default_locale->empty()) {
+    icu::Locale icu_default;
+    char result[ULOC_FULLNAME_CAPACITY];
+    UErrorCode status = U_ZERO_ERROR;
+    uloc_toLanguageTag(icu_default.getName(), result, ULOC_FULLNAME_CAPACITY,
+                       FALSE, &status);
+    default_locale->assign(U_SUCCESS(status) ? result : "und");
+  }
+  return *default_locale;
+}
+
+// Splits Accept-Language header into language ranges, ordered by quality.
+// Ranges with zero quality, wildcards and malformed entries are dropped.
+// Example: "da, en-gb;q=0.8, en;q=0.7"
+static void ParseAcceptLanguage(const std::string& header,
+                                std::vector<WeightedLanguage>* languages) {
+  size_t start = 0;
+  while (start <= header.length()) {
+    size_t end = header.find(',', start);
+    if (end == std::string::npos) {
+      end = header.length();
+    }
+    std::string entry = header.substr(start, end - start);
+    start = end + 1;
+
+    WeightedLanguage language;
+    language.quality = 1000;
+
+    size_t parameters = entry.find(';');
+    language.tag = Trim(entry.substr(0, parameters));
+    if (parameters != std::string::npos) {
+      std::string quality = Trim(entry.substr(parameters + 1));
+      if (quality.length() < 2 || (quality[0] != 'q' && quality[0] != 'Q') ||
+          quality[1] != '=') {
+        continue;
+      }
+      language.quality = ParseQuality(Trim(quality.substr(2)));
+    }
+
+    if (language.tag.empty() || language.tag == "*" ||
+        language.quality <= 0) {
+      continue;
+    }
+    languages->push_back(language);
+  }
+
+  std::stable_sort(languages->begin(), languages->end(), CompareQuality);
+}
+
+// Parses qvalue (RFC 2616, section 3.9) into thousandths.
+// Returns -1 if the value is malformed.
+static int ParseQuality(const std::string& value) {
+  if (value.empty() || (value[0] != '0' && value[0] != '1')) {
+    return -1;
+  }
+
+  int quality = (value[0] - '0') * 1000;
+  if (value.length() == 1) {
+    return quality;
+  }
+  if (value[1] != '.' || value.length() > 5) {
+    return -1;
+  }
+
+  int scale = 100;
+  for (size_t i = 2; i < value.length(); ++i, scale /= 10) {
+    if (value[i] < '0' || value[i] > '9') {
+      return -1;
+    }
+    quality += (value[i] - '0') * scale;
+  }
+
+  return quality > 1000 ? -1 : quality;
+}
+
+// Orders languages by descending quality. Sort has to be stable, so
+// header order is kept for equal qualities.
+static bool CompareQuality(const WeightedLanguage& a,
+                           const WeightedLanguage& b) {
+  return a.quality > b.quality;
+}
+
+// Removes leading and trailing spaces and tabs.
+static std::string Trim(const std::string& value) {
+  size_t start = value.find_first_not_of(" \t");
+  if (start == std::string::npos) {
+    return std::string();
+  }
+  size_t end = value.find_last_not_of(" \t");
+  return value.substr(start, end - start + 1);
+}
+
+// Splits the tag, with likely subtags added, into language, script and
+// region. Language is mapped to the code ICU data uses.
+// Returns false if ICU can't parse the tag.
+static bool MaximizeTag(const std::string& tag,
+                        std::string* language,
+                        std::string* script,
+                        std::string* region) {
+  UErrorCode error = U_ZERO_ERROR;
+  char icu_locale[ULOC_FULLNAME_CAPACITY];
+  int icu_locale_length = 0;
+  uloc_forLanguageTag(tag.c_str(), icu_locale, ULOC_FULLNAME_CAPACITY,
+                      &icu_locale_length, &error);
+  if (U_FAILURE(error) || icu_locale_length == 0) {
+    return false;
+  }
+
+  char icu_max_locale[ULOC_FULLNAME_CAPACITY];
+  uloc_addLikelySubtags(
+      icu_locale, icu_max_locale, ULOC_FULLNAME_CAPACITY, &error);
+
+  char subtag[ULOC_FULLNAME_CAPACITY];
+  uloc_getLanguage(icu_max_locale, subtag, ULOC_FULLNAME_CAPACITY, &error);
+  *language = subtag;
+  uloc_getScript(icu_max_locale, subtag, ULOC_FULLNAME_CAPACITY, &error);
+  *script = subtag;
+  uloc_getCountry(icu_max_locale, subtag, ULOC_FULLNAME_CAPACITY, &error);
+  *region = subtag;
+  if (U_FAILURE(error)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < sizeof(kEquivalentLanguages) /
+                         sizeof(kEquivalentLanguages[0]); ++i) {
+    if (*language == kEquivalentLanguages[i][0]) {
+      *language = kEquivalentLanguages[i][1];
+      break;
+    }
+  }
+
+  return true;
+}
+
+// Returns index of the language's region group the region belongs to,
+// or -1 if it doesn't belong to any.
+static int GetRegionGroup(const std::string& language,
+                          const std::string& region) {
+  if (region.empty()) {
+    return -1;
+  }
+
+  for (size_t i = 0; i < sizeof(kRegionGroups) / sizeof(kRegionGroups[0]);
+       ++i) {
+    if (language != kRegionGroups[i][0]) {
+      continue;
+    }
+    std::string regions(" ");
+    regions.append(kRegionGroups[i][1]);
+    regions.push_back(' ');
+    if (regions.find(" " + region + " ") != std::string::npos) {
+      return static_cast<int>(i);
+    }
+  }
+
+  return -1;
+}
+
+// Converts ICU locale name into BCP47 tag. Services share most of their
+// locales, so conversions are memoized across them.
+// Returns false if ICU can't convert the name.
+static bool ToLanguageTag(const char* icu_name, std::string* tag) {
+  // It holds at most a few hundred names ICU has data for.
+  NameMap* tags = IsolateData::Current()->GetOrCreate<NameMap>(
+      IsolateData::ICU_LOCALE_NAMES);
+
+  NameMap::iterator it = tags->find(icu_name);
+  if (it != tags->end()) {
+    *tag = it->second;
+    return true;
+  }
+
+  char result[ULOC_FULLNAME_CAPACITY];
+  UErrorCode error = U_ZERO_ERROR;
+  // No need to force strict BCP47 rules.
+  uloc_toLanguageTag(icu_name, result, ULOC_FULLNAME_CAPACITY, FALSE, &error);
+  if (U_FAILURE(error)) {
+    return false;
+  }
+
+  *tag = result;
+  (*tags)[icu_name] = *tag;
+  return true;
+}
+
+// Returns true if the tag is xx-Yyyy-ZZ (or xxx-Yyyy-ZZ), and sets
+// |script| and |region| to positions of the subtags.
+static bool IsLanguageScriptRegion(const std::string& tag,
+                                   size_t* script,
+                                   size_t* region) {
+  size_t language_length = tag.find('-');
+  if (language_length != 2 && language_length != 3) {
+    return false;
+  }
+  if (tag.length() != language_length + 9) {
+    return false;
+  }
+
+  for (size_t i = 0; i < language_length; ++i) {
+    if (tag[i] < 'a' || tag[i] > 'z') {
+      return false;
+    }
+  }
+
+  *script = language_length + 1;
+  *region = *script + 5;
+  const char* s = tag.c_str() + *script;
+  const char* r = tag.c_str() + *region;
+  return s[-1] == '-' && s[0] >= 'A' && s[0] <= 'Z' &&
+         s[1] >= 'a' && s[1] <= 'z' && s[2] >= 'a' && s[2] <= 'z' &&
+         s[3] >= 'a' && s[3] <= 'z' && r[-1] == '-' &&
+         r[0] >= 'A' && r[0] <= 'Z' && r[1] >= 'A' && r[1] <= 'Z';
+}
+
+}  // namespace v8_i18n
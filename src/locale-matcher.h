@@ -0,0 +1,135 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef V8_I18N_SRC_LOCALE_MATCHER_H_
+#define V8_I18N_SRC_LOCALE_MATCHER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/lru-cache.h"
+
+namespace v8_i18n {
+
+// Result of matching a requested locale list against available locales.
+struct LocaleMatch {
+  // Matched available locale, or default ICU locale if nothing matched.
+  std::string locale;
+  // Unicode extension (-u-...) of the matched requested locale, if any.
+  std::string extension;
+  // Index of the matched requested locale, -1 if nothing matched.
+  int position;
+};
+
+// Matches BCP47 language tags against available locales of one service.
+// Available locales are fetched from ICU once, and results of matching
+// whole requested lists are memoized.
+class LocaleMatcher {
+ public:
+  // Returns the matcher for collator, numberformat, dateformat or
+  // breakiterator service, creating it on first use. Returns NULL for
+  // unknown services.
+  static LocaleMatcher* Get(const std::string& service);
+
+  // Returns true if the locale, or one of its truncations, is available,
+  // and sets |match| to it. Extensions have to be removed by the caller.
+  bool LookupLocale(const std::string& locale, std::string* match) const;
+
+  // Implements BCP47 Lookup algorithm over canonicalized requested locales.
+  // Returns the first one with a match, or the default locale.
+  const LocaleMatch& Lookup(const std::vector<std::string>& requested);
+
+  // Returns requested locales that have a match, in their original order.
+  void LookupSupported(const std::vector<std::string>& requested,
+                       std::vector<std::string>* supported) const;
+
+  // Returns true if there's an available locale in the same language and
+  // script as the locale, and sets |match| to the closest one by region.
+  // Falls back to lookup. Extensions have to be removed by the caller.
+  bool BestFitLocale(const std::string& locale, std::string* match);
+
+  // Best fit counterparts of Lookup and LookupSupported. A requested locale
+  // is matched by its likely script and region, so zh-HK picks zh-Hant-TW
+  // over zh (Simplified), and en-AU picks en-GB over en-US.
+  const LocaleMatch& BestFit(const std::vector<std::string>& requested);
+  void BestFitSupported(const std::vector<std::string>& requested,
+                        std::vector<std::string>* supported);
+
+  // Parses Accept-Language header, orders languages by quality, and
+  // returns the best fit for them (extension included), or the default
+  // locale. Results are cached per header.
+  const std::string& MatchAcceptLanguage(const std::string& header);
+
+  // Removes all extensions and private use subtags from the tag.
+  static std::string RemoveExtensions(const std::string& tag);
+
+  // Splits the Unicode extension out of the tag. Returns the tag without
+  // it, and sets |extension| to it, or to empty string.
+  static std::string RemoveUnicodeExtension(const std::string& tag,
+                                            std::string* extension);
+
+  // Returns the default ICU locale as a BCP47 tag.
+  static const std::string& DefaultLocale();
+
+ private:
+  // Available locale with its likely subtags.
+  struct Candidate {
+    std::string tag;
+    std::string script;
+    std::string region;
+  };
+
+  // Matchers are fed requested lists and headers from web pages, so memos
+  // are bounded.
+  typedef LruCache<LocaleMatch, 256> MatchMap;
+  typedef std::map<std::string, std::vector<Candidate> > CandidateMap;
+  typedef LruCache<std::string, 1024> TagMap;
+  typedef LruCache<std::string, 256> HeaderMap;
+
+  explicit LocaleMatcher(const std::string& service);
+
+  // Returns the best match for the requested list in |memo|, computing it
+  // with |match_locale| on a miss.
+  const LocaleMatch& Match(
+      const std::vector<std::string>& requested,
+      bool (LocaleMatcher::*match_locale)(const std::string&, std::string*),
+      MatchMap* memo);
+
+  // Non const wrapper of LookupLocale, for Match.
+  bool LookupLocaleForMatch(const std::string& locale, std::string* match);
+
+  bool IsAvailable(const std::string& locale) const;
+
+  // Available locales in BCP47 form, with xx-ZZ added for each xx-Yyyy-ZZ.
+  // Sorted, so lookups are binary searches over contiguous memory.
+  std::vector<std::string> available_;
+
+  // Available locales grouped by language, built on first best fit.
+  CandidateMap candidates_;
+
+  // Lookup and best fit results keyed by requested list.
+  MatchMap memo_;
+  MatchMap best_fit_memo_;
+
+  // Best fit results keyed by single locale, empty if there's no match.
+  TagMap best_fit_locales_;
+
+  // Results keyed by Accept-Language header.
+  HeaderMap accept_language_memo_;
+};
+
+}  // namespace v8_i18n
+
+#endif  // V8_I18N_SRC_LOCALE_MATCHER_H_
@@ -14,17 +14,29 @@
 
 #include "src/locale.h"
 
-#include <string.h>
-
-#include "unicode/brkiter.h"
-#include "unicode/coll.h"
-#include "unicode/datefmt.h"
-#include "unicode/numfmt.h"
+#include <string>
+#include <vector>
+
+#include "src/isolate-data.h"
+#include "src/language-tag.h"
+#include "src/locale-matcher.h"
+#include "src/lru-cache.h"
+#include "src/property-names.h"
 #include "unicode/uloc.h"
 #include "unicode/uversion.h"
 
 namespace v8_i18n {
 
+// Optimal tags, keyed by requested and resolved tag.
+static const size_t kMaxOptimalTags = 256;
+typedef LruCache<std::string, kMaxOptimalTags> TagMap;
+
+static bool GetLanguageTagVariants(const char*, std::string*, std::string*);
+static LocaleMatcher* GetMatcherAndTags(
+    const v8::FunctionCallbackInfo<v8::Value>&, std::vector<std::string>*);
+static v8::Handle<v8::Object> NewMatchObject(const LocaleMatch&);
+static v8::Handle<v8::Array> NewTagArray(const std::vector<std::string>&);
+
 void JSCanonicalizeLanguageTag(const v8::FunctionCallbackInfo<v8::Value>& args) {
   // Expect locale id which is a string.
   if (args.Length() != 1 || !args[0]->IsString()) {
@@ -33,201 +45,269 @@ void JSCanonicalizeLanguageTag(const v8::FunctionCallbackInfo<v8::Value>& args)
     return;
   }
 
-  UErrorCode error = U_ZERO_ERROR;
-
-  char icu_result[ULOC_FULLNAME_CAPACITY];
-  int icu_length = 0;
-
   // Return value which denotes invalid language tag.
   const char* const kInvalidTag = "invalid-tag";
 
-  v8::String::AsciiValue locale_id(args[0]->ToString());
+  // Valid tags are ASCII only. Don't let lossy conversion make a valid tag
+  // out of an invalid one.
+  v8::String::Value locale_id(args[0]);
   if (*locale_id == NULL) {
     args.GetReturnValue().Set(v8::String::New(kInvalidTag));
     return;
   }
 
-  uloc_forLanguageTag(*locale_id, icu_result, ULOC_FULLNAME_CAPACITY,
-                      &icu_length, &error);
-  if (U_FAILURE(error) || icu_length == 0) {
-    args.GetReturnValue().Set(v8::String::New(kInvalidTag));
-    return;
+  std::string tag;
+  for (int i = 0; i < locale_id.length(); ++i) {
+    if ((*locale_id)[i] > 0x7F) {
+      args.GetReturnValue().Set(v8::String::New(kInvalidTag));
+      return;
+    }
+    tag.push_back(static_cast<char>((*locale_id)[i]));
   }
 
-  char result[ULOC_FULLNAME_CAPACITY];
-
-  // Force strict BCP47 rules.
-  uloc_toLanguageTag(icu_result, result, ULOC_FULLNAME_CAPACITY, TRUE, &error);
-
-  if (U_FAILURE(error)) {
+  std::string canonical;
+  if (!LanguageTag::Canonicalize(tag, &canonical)) {
     args.GetReturnValue().Set(v8::String::New(kInvalidTag));
     return;
   }
 
-  args.GetReturnValue().Set(v8::String::New(result));
+  args.GetReturnValue().Set(v8::String::New(canonical.c_str()));
 }
 
-void JSAvailableLocalesOf(const v8::FunctionCallbackInfo<v8::Value>& args) {
-  // Expect service name which is a string.
-  if (args.Length() != 1 || !args[0]->IsString()) {
+void JSGetOptimalLanguageTag(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  if (args.Length() != 2 || !args[0]->IsString() || !args[1]->IsString()) {
     v8::ThrowException(v8::Exception::SyntaxError(
-        v8::String::New("Service identifier, as a string, is required.")));
+        v8::String::New("Internal error. Requested and resolved locales "
+                        "are required.")));
     return;
   }
 
-  const icu::Locale* available_locales = NULL;
+  TagMap* optimal_tags = IsolateData::Current()->GetOrCreate<TagMap>(
+      IsolateData::OPTIMAL_LANGUAGE_TAGS);
+
+  v8::String::AsciiValue original(args[0]);
+  v8::String::AsciiValue resolved(args[1]);
+  std::string key(*original, original.length());
+  key.push_back('\0');
+  key.append(*resolved, resolved.length());
 
-  int32_t count = 0;
-  v8::String::AsciiValue service(args[0]->ToString());
-  if (strcmp(*service, "collator") == 0) {
-    available_locales = icu::Collator::getAvailableLocales(count);
-  } else if (strcmp(*service, "numberformat") == 0) {
-    available_locales = icu::NumberFormat::getAvailableLocales(count);
-  } else if (strcmp(*service, "dateformat") == 0) {
-    available_locales = icu::DateFormat::getAvailableLocales(count);
-  } else if (strcmp(*service, "breakiterator") == 0) {
-    available_locales = icu::BreakIterator::getAvailableLocales(count);
+  std::string* cached = optimal_tags->Find(key);
+  if (cached) {
+    args.GetReturnValue().Set(v8::String::New(cached->c_str()));
+    return;
   }
 
-  v8::TryCatch try_catch;
-  UErrorCode error = U_ZERO_ERROR;
-  char result[ULOC_FULLNAME_CAPACITY];
-  v8::Handle<v8::Object> locales = v8::Object::New();
-
-  for (int32_t i = 0; i < count; ++i) {
-    const char* icu_name = available_locales[i].getName();
-
-    error = U_ZERO_ERROR;
-    // No need to force strict BCP47 rules.
-    uloc_toLanguageTag(icu_name, result, ULOC_FULLNAME_CAPACITY, FALSE, &error);
-    if (U_FAILURE(error)) {
-      // This shouldn't happen, but lets not break the user.
-      continue;
-    }
+  std::string original_maximized;
+  std::string original_base;
+  std::string resolved_maximized;
+  std::string resolved_base;
+  if (!GetLanguageTagVariants(*original, &original_maximized,
+                              &original_base) ||
+      !GetLanguageTagVariants(*resolved, &resolved_maximized,
+                              &resolved_base)) {
+    v8::ThrowException(v8::Exception::SyntaxError(
+        v8::String::New("Internal error. Couldn't generate maximized "
+                        "or base locale.")));
+    return;
+  }
 
-    // Index is just a dummy value for the property value.
-    locales->Set(v8::String::New(result), v8::Integer::New(i));
-    if (try_catch.HasCaught()) {
-      // Ignore error, but stop processing and return.
-      break;
-    }
+  // Preserve extensions of resolved locale, but swap base tags with
+  // original, if they are equivalent.
+  std::string result(*resolved, resolved.length());
+  if (original_maximized == resolved_maximized &&
+      result.compare(0, resolved_base.length(), resolved_base) == 0) {
+    result.replace(0, resolved_base.length(), original_base);
   }
 
-  args.GetReturnValue().Set(locales);
+  *optimal_tags->Insert(key, NULL) = result;
+
+  args.GetReturnValue().Set(v8::String::New(result.c_str()));
 }
 
-void JSGetDefaultICULocale(const v8::FunctionCallbackInfo<v8::Value>& args) {
-  icu::Locale default_locale;
+void JSLookupMatcher(const v8::FunctionCallbackInfo<v8::Value>& args) {
+  std::vector<std::string> requested;
+  LocaleMatcher* matcher = GetMatcherAndTags(args, &requested);
+  if (!matcher) {
+    return;
+  }
+
+  args.GetReturnValue().Set(NewMatchObject(matcher->Lookup(requested)));
+}
 
-  // Set the locale
-  char result[ULOC_FULLNAME_CAPACITY];
-  UErrorCode status = U_ZERO_ERROR;
-  uloc_toLanguageTag(
-      default_locale.getName(), result, ULOC_FULLNAME_CAPACITY, FALSE, &status);
-  if (U_SUCCESS(status)) {
-    args.GetReturnValue().Set(v8::String::New(result));
+void JSBestFitMatcher(const v8::FunctionCallbackInfo<v8::Value>& args) {
+  std::vector<std::string> requested;
+  LocaleMatcher* matcher = GetMatcherAndTags(args, &requested);
+  if (!matcher) {
+    return;
+  }
+
+  args.GetReturnValue().Set(NewMatchObject(matcher->BestFit(requested)));
+}
+
+void JSLookupSupportedLocalesOf(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  std::vector<std::string> requested;
+  LocaleMatcher* matcher = GetMatcherAndTags(args, &requested);
+  if (!matcher) {
     return;
   }
 
-  args.GetReturnValue().Set(v8::String::New("und"));
+  std::vector<std::string> supported;
+  matcher->LookupSupported(requested, &supported);
+  args.GetReturnValue().Set(NewTagArray(supported));
 }
 
-void JSGetLanguageTagVariants(const v8::FunctionCallbackInfo<v8::Value>& args) {
-  v8::TryCatch try_catch;
+void JSBestFitSupportedLocalesOf(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  std::vector<std::string> requested;
+  LocaleMatcher* matcher = GetMatcherAndTags(args, &requested);
+  if (!matcher) {
+    return;
+  }
+
+  std::vector<std::string> supported;
+  matcher->BestFitSupported(requested, &supported);
+  args.GetReturnValue().Set(NewTagArray(supported));
+}
 
-  // Expect an array of strings.
-  if (args.Length() != 1 || !args[0]->IsArray()) {
+void JSMatchAcceptLanguage(const v8::FunctionCallbackInfo<v8::Value>& args) {
+  if (args.Length() != 2 || !args[0]->IsString() || !args[1]->IsString()) {
     v8::ThrowException(v8::Exception::SyntaxError(
-        v8::String::New("Internal error. Expected Array<String>.")));
+        v8::String::New("Internal error. Header and service are required.")));
     return;
   }
 
-  v8::Local<v8::Array> input = v8::Local<v8::Array>::Cast(args[0]);
-  v8::Handle<v8::Array> output = v8::Array::New(input->Length());
-  for (unsigned int i = 0; i < input->Length(); ++i) {
-    v8::Local<v8::Value> locale_id = input->Get(i);
-    if (try_catch.HasCaught()) {
-      break;
-    }
+  v8::String::AsciiValue service(args[1]);
+  LocaleMatcher* matcher = LocaleMatcher::Get(*service);
+  if (!matcher) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New("Internal error, wrong service type.")));
+    return;
+  }
 
-    if (!locale_id->IsString()) {
-      v8::ThrowException(v8::Exception::SyntaxError(
-          v8::String::New("Internal error. Array element is missing "
-                          "or it isn't a string.")));
-      return;
-    }
+  v8::String::AsciiValue header(args[0]);
+  std::string header_string;
+  if (*header != NULL) {
+    header_string.assign(*header, header.length());
+  }
 
-    v8::String::AsciiValue ascii_locale_id(locale_id);
-    if (*ascii_locale_id == NULL) {
-      v8::ThrowException(v8::Exception::SyntaxError(
-          v8::String::New("Internal error. Non-ASCII locale identifier.")));
-      return;
-    }
+  args.GetReturnValue().Set(v8::String::New(
+      matcher->MatchAcceptLanguage(header_string).c_str()));
+}
 
-    UErrorCode error = U_ZERO_ERROR;
+// Converts match result into {locale, extension, position} object.
+static v8::Handle<v8::Object> NewMatchObject(const LocaleMatch& match) {
+  v8::Handle<v8::Object> result = v8::Object::New();
+  result->Set(PropertyNames::Get(PropertyNames::LOCALE),
+              v8::String::New(match.locale.c_str()));
+  result->Set(PropertyNames::Get(PropertyNames::EXTENSION),
+              v8::String::New(match.extension.c_str()));
+  result->Set(PropertyNames::Get(PropertyNames::POSITION),
+              v8::Integer::New(match.position));
+  return result;
+}
 
-    // Convert from BCP47 to ICU format.
-    // de-DE-u-co-phonebk -> de_DE@collation=phonebook
-    char icu_locale[ULOC_FULLNAME_CAPACITY];
-    int icu_locale_length = 0;
-    uloc_forLanguageTag(*ascii_locale_id, icu_locale, ULOC_FULLNAME_CAPACITY,
-                        &icu_locale_length, &error);
-    if (U_FAILURE(error) || icu_locale_length == 0) {
-      v8::ThrowException(v8::Exception::SyntaxError(
-          v8::String::New("Internal error. Failed to convert locale to ICU.")));
-      return;
-    }
+// Converts a list of language tags into an array of strings.
+static v8::Handle<v8::Array> NewTagArray(const std::vector<std::string>& tags) {
+  v8::Handle<v8::Array> result = v8::Array::New(tags.size());
+  for (size_t i = 0; i < tags.size(); ++i) {
+    result->Set(i, v8::String::New(tags[i].c_str()));
+  }
+  return result;
+}
 
-    // Maximize the locale.
-    // de_DE@collation=phonebook -> de_Latn_DE@collation=phonebook
-    char icu_max_locale[ULOC_FULLNAME_CAPACITY];
-    uloc_addLikelySubtags(
-        icu_locale, icu_max_locale, ULOC_FULLNAME_CAPACITY, &error);
-
-    // Remove extensions from maximized locale.
-    // de_Latn_DE@collation=phonebook -> de_Latn_DE
-    char icu_base_max_locale[ULOC_FULLNAME_CAPACITY];
-    uloc_getBaseName(
-        icu_max_locale, icu_base_max_locale, ULOC_FULLNAME_CAPACITY, &error);
-
-    // Get original name without extensions.
-    // de_DE@collation=phonebook -> de_DE
-    char icu_base_locale[ULOC_FULLNAME_CAPACITY];
-    uloc_getBaseName(
-        icu_locale, icu_base_locale, ULOC_FULLNAME_CAPACITY, &error);
-
-    // Convert from ICU locale format to BCP47 format.
-    // de_Latn_DE -> de-Latn-DE
-    char base_max_locale[ULOC_FULLNAME_CAPACITY];
-    uloc_toLanguageTag(icu_base_max_locale, base_max_locale,
-                       ULOC_FULLNAME_CAPACITY, FALSE, &error);
-
-    // de_DE -> de-DE
-    char base_locale[ULOC_FULLNAME_CAPACITY];
-    uloc_toLanguageTag(
-        icu_base_locale, base_locale, ULOC_FULLNAME_CAPACITY, FALSE, &error);
-
-    if (U_FAILURE(error)) {
-      v8::ThrowException(v8::Exception::SyntaxError(
-          v8::String::New("Internal error. Couldn't generate maximized "
-                          "or base locale.")));
-      return;
-    }
+// Computes maximized and base forms of the tag, both without extensions.
+// zh-TW-u-nu-thai -> zh-Hant-TW and zh-TW.
+// Returns false if ICU fails to convert the tag.
+static bool GetLanguageTagVariants(const char* tag,
+                                   std::string* maximized,
+                                   std::string* base) {
+  UErrorCode error = U_ZERO_ERROR;
 
-    v8::Handle<v8::Object> result = v8::Object::New();
-    result->Set(v8::String::New("maximized"), v8::String::New(base_max_locale));
-    result->Set(v8::String::New("base"), v8::String::New(base_locale));
-    if (try_catch.HasCaught()) {
-      break;
-    }
+  // Convert from BCP47 to ICU format.
+  // de-DE-u-co-phonebk -> de_DE@collation=phonebook
+  char icu_locale[ULOC_FULLNAME_CAPACITY];
+  int icu_locale_length = 0;
+  uloc_forLanguageTag(tag, icu_locale, ULOC_FULLNAME_CAPACITY,
+                      &icu_locale_length, &error);
+  if (U_FAILURE(error) || icu_locale_length == 0) {
+    return false;
+  }
+
+  // Maximize the locale.
+  // de_DE@collation=phonebook -> de_Latn_DE@collation=phonebook
+  char icu_max_locale[ULOC_FULLNAME_CAPACITY];
+  uloc_addLikelySubtags(
+      icu_locale, icu_max_locale, ULOC_FULLNAME_CAPACITY, &error);
+
+  // Remove extensions from maximized locale.
+  // de_Latn_DE@collation=phonebook -> de_Latn_DE
+  char icu_base_max_locale[ULOC_FULLNAME_CAPACITY];
+  uloc_getBaseName(
+      icu_max_locale, icu_base_max_locale, ULOC_FULLNAME_CAPACITY, &error);
+
+  // Get original name without extensions.
+  // de_DE@collation=phonebook -> de_DE
+  char icu_base_locale[ULOC_FULLNAME_CAPACITY];
+  uloc_getBaseName(
+      icu_locale, icu_base_locale, ULOC_FULLNAME_CAPACITY, &error);
+
+  // Convert from ICU locale format to BCP47 format.
+  // de_Latn_DE -> de-Latn-DE
+  char base_max_locale[ULOC_FULLNAME_CAPACITY];
+  uloc_toLanguageTag(icu_base_max_locale, base_max_locale,
+                     ULOC_FULLNAME_CAPACITY, FALSE, &error);
+
+  // de_DE -> de-DE
+  char base_locale[ULOC_FULLNAME_CAPACITY];
+  uloc_toLanguageTag(
+      icu_base_locale, base_locale, ULOC_FULLNAME_CAPACITY, FALSE, &error);
+
+  if (U_FAILURE(error)) {
+    return false;
+  }
+
+  *maximized = base_max_locale;
+  *base = base_locale;
+  return true;
+}
 
-    output->Set(i, result);
-    if (try_catch.HasCaught()) {
-      break;
+// Returns the matcher for the service in the first argument, and copies
+// language tags from the array in the second one. Throws and returns NULL
+// on bad arguments.
+static LocaleMatcher* GetMatcherAndTags(
+    const v8::FunctionCallbackInfo<v8::Value>& args,
+    std::vector<std::string>* tags) {
+  if (args.Length() != 2 || !args[0]->IsString() || !args[1]->IsArray()) {
+    v8::ThrowException(v8::Exception::SyntaxError(
+        v8::String::New("Internal error. Service and Array<String> "
+                        "are required.")));
+    return NULL;
+  }
+
+  v8::String::AsciiValue service(args[0]);
+  LocaleMatcher* matcher = LocaleMatcher::Get(*service);
+  if (!matcher) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New("Internal error, wrong service type.")));
+    return NULL;
+  }
+
+  v8::Local<v8::Array> input = v8::Local<v8::Array>::Cast(args[1]);
+  for (unsigned int i = 0; i < input->Length(); ++i) {
+    // Tags are canonicalized, so they are plain ASCII.
+    v8::String::AsciiValue tag(input->Get(i));
+    if (*tag == NULL) {
+      v8::ThrowException(v8::Exception::SyntaxError(
+          v8::String::New("Internal error. Array element is missing "
+                          "or it isn't a string.")));
+      return NULL;
     }
+    tags->push_back(std::string(*tag, tag.length()));
   }
 
-  args.GetReturnValue().Set(output);
+  return matcher;
 }
 
 }  // namespace v8_i18n
@@ -20,22 +20,43 @@
 
 namespace v8_i18n {
 
-// Canonicalizes the BCP47 language tag using BCP47 rules.
-// Returns 'invalid-tag' in case input was not well formed.
+// Validates and canonicalizes the BCP47 language tag using BCP47 rules.
+// Returns 'invalid-tag' in case input was not well formed, or had duplicate
+// variants or singletons.
 void JSCanonicalizeLanguageTag(const v8::FunctionCallbackInfo<v8::Value>& args);
 
-// Returns a list of available locales for collator, date or number formatter.
-void JSAvailableLocalesOf(const v8::FunctionCallbackInfo<v8::Value>& args);
-
-// Returns default ICU locale.
-void JSGetDefaultICULocale(const v8::FunctionCallbackInfo<v8::Value>& args);
-
-// Returns an array of objects, that have maximized and base names of inputs.
-// Unicode extensions are dropped from both.
-// Input: ['zh-TW-u-nu-thai', 'sr']
-// Output: [{maximized: 'zh-Hant-TW', base: 'zh-TW'},
-//          {maximized: 'sr-Cyrl-RS', base: 'sr'}]
-void JSGetLanguageTagVariants(const v8::FunctionCallbackInfo<v8::Value>& args);
+// Returns requested locale if its maximized form matches the resolved one,
+// keeping extensions of the resolved locale. Otherwise returns resolved
+// locale. Results are memoized.
+// Input: 'zh-TW', 'zh-Hant-TW-u-nu-latn'
+// Output: 'zh-TW-u-nu-latn'
+void JSGetOptimalLanguageTag(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+// Implements BCP47 Lookup over a canonicalized locale list for a service.
+// Returns {locale, extension, position} of the first requested locale with
+// an available match, or of the default locale (position -1).
+// Input: 'collator', ['de-CH-u-co-phonebk', 'en']
+// Output: {locale: 'de', extension: '-u-co-phonebk', position: 0}
+void JSLookupMatcher(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+// Returns requested locales that have an available match for the service,
+// extensions included, in the original order.
+void JSLookupSupportedLocalesOf(
+    const v8::FunctionCallbackInfo<v8::Value>& args);
+
+// Same as JSLookupMatcher and JSLookupSupportedLocalesOf, but matches
+// locales by their likely script and region.
+// Input: 'numberformat', ['zh-HK']
+// Output: {locale: 'zh-Hant-HK', extension: '', position: 0}
+void JSBestFitMatcher(const v8::FunctionCallbackInfo<v8::Value>& args);
+void JSBestFitSupportedLocalesOf(
+    const v8::FunctionCallbackInfo<v8::Value>& args);
+
+// Parses Accept-Language header and returns the best fit locale of the
+// service for it, or the default locale.
+// Input: 'da, en-gb;q=0.8, en;q=0.7', 'collator'
+// Output: 'da'
+void JSMatchAcceptLanguage(const v8::FunctionCallbackInfo<v8::Value>& args);
 
 }  // namespace v8_i18n
 
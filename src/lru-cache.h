@@ -0,0 +1,95 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef V8_I18N_SRC_LRU_CACHE_H_
+#define V8_I18N_SRC_LRU_CACHE_H_
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace v8_i18n {
+
+// String keyed cache that holds at most kCapacity entries, and drops the
+// least recently used one to make room for a new one. Keys often come
+// from web pages, so caches of derived data have to stay bounded, without
+// losing the entries that are in use.
+// Pointers to values stay valid until their entry is dropped.
+template <class Value, size_t kCapacity>
+class LruCache {
+ public:
+  LruCache() {}
+
+  // Returns the value stored for the key, and marks it most recently used.
+  // Returns NULL if the key isn't cached.
+  Value* Find(const std::string& key) {
+    typename Index::iterator it = index_.find(key);
+    if (it == index_.end()) {
+      return NULL;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value;
+  }
+
+  // Adds an entry for the key, which must not be cached yet, and returns its
+  // default constructed value for the caller to fill in. If the cache is
+  // full, the least recently used entry is dropped first, and its value is
+  // stored in |evicted|, unless that's NULL. |evicted| is left alone if
+  // nothing was dropped.
+  Value* Insert(const std::string& key, Value* evicted) {
+    if (entries_.size() >= kCapacity) {
+      RemoveOldest(evicted);
+    }
+    entries_.push_front(Entry());
+    entries_.front().key = key;
+    index_[key] = entries_.begin();
+    return &entries_.front().value;
+  }
+
+  // Drops the least recently used entry, and stores its value in |value|,
+  // unless that's NULL. Returns false if the cache is empty.
+  bool RemoveOldest(Value* value) {
+    if (entries_.empty()) {
+      return false;
+    }
+    if (value) {
+      *value = entries_.back().value;
+    }
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+    return true;
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    std::string key;
+    Value value;
+  };
+
+  typedef std::list<Entry> EntryList;
+  typedef std::map<std::string, typename EntryList::iterator> Index;
+
+  // Most recently used first.
+  EntryList entries_;
+  Index index_;
+
+  LruCache(const LruCache&);
+  void operator=(const LruCache&);
+};
+
+}  // namespace v8_i18n
+
+#endif  // V8_I18N_SRC_LRU_CACHE_H_
@@ -22,6 +22,9 @@ class Natives {
   // Gets script source from generated file.
   // Source is statically allocated string.
   static const char* GetScriptSource();
+
+  // Gets script source length, without the terminating null.
+  static int GetScriptSourceLength();
 };
 
 }  // namespace v8_i18n
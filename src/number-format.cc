@@ -16,6 +16,11 @@
 
 #include <string.h>
 
+#include <string>
+
+#include "src/locale-matcher.h"
+#include "src/option-resolver.h"
+#include "src/property-names.h"
 #include "src/utils.h"
 #include "unicode/curramt.h"
 #include "unicode/dcfmtsym.h"
@@ -30,24 +35,49 @@
 
 namespace v8_i18n {
 
-static icu::DecimalFormat* InitializeNumberFormat(v8::Handle<v8::String>,
-                                                  v8::Handle<v8::Object>,
+// Number format options resolved from user options.
+struct NumberFormatOptions {
+  NumberFormatOptions()
+      : style("decimal"),
+        currency_display("symbol"),
+        minimum_integer_digits(1),
+        minimum_fraction_digits(0),
+        maximum_fraction_digits(3),
+        has_significant_digits(false),
+        minimum_significant_digits(0),
+        maximum_significant_digits(21),
+        use_grouping(true) {}
+
+  std::string style;
+  // Upper case ISO 4217 code, empty unless style is currency.
+  std::string currency;
+  std::string currency_display;
+  int32_t minimum_integer_digits;
+  int32_t minimum_fraction_digits;
+  int32_t maximum_fraction_digits;
+  bool has_significant_digits;
+  int32_t minimum_significant_digits;
+  int32_t maximum_significant_digits;
+  bool use_grouping;
+};
+
+static bool ResolveNumberFormatOptions(v8::Handle<v8::Array>,
+                                       v8::Handle<v8::Object>,
+                                       std::string*,
+                                       NumberFormatOptions*);
+static icu::DecimalFormat* InitializeNumberFormat(const std::string&,
+                                                  const NumberFormatOptions&,
                                                   v8::Handle<v8::Object>);
 static icu::DecimalFormat* CreateICUNumberFormat(const icu::Locale&,
-                                                 v8::Handle<v8::Object>);
+                                                 const NumberFormatOptions&);
 static void SetResolvedSettings(const icu::Locale&,
                                 icu::DecimalFormat*,
+                                const NumberFormatOptions&,
                                 v8::Handle<v8::Object>);
 
 icu::DecimalFormat* NumberFormat::UnpackNumberFormat(
     v8::Handle<v8::Object> obj) {
-  v8::HandleScope handle_scope;
-
-  // v8::ObjectTemplate doesn't have HasInstance method so we can't check
-  // if obj is an instance of NumberFormat class. We'll check for a property
-  // that has to be in the object. The same applies to other services, like
-  // Collator and DateTimeFormat.
-  if (obj->HasOwnProperty(v8::String::New("numberFormat"))) {
+  if (Utils::HasWrapperType(obj, Utils::NUMBER_FORMAT_WRAPPER)) {
     return static_cast<icu::DecimalFormat*>(
         obj->GetAlignedPointerFromInternalField(0));
   }
@@ -72,7 +102,7 @@ void NumberFormat::DeleteNumberFormat(v8::Isolate* isolate,
 
 void NumberFormat::JSInternalFormat(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
-  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsNumber()) {
+  if (args.Length() != 2 || !args[0]->IsObject()) {
     v8::ThrowException(v8::Exception::Error(
         v8::String::New("Formatter and numeric value have to be specified.")));
     return;
@@ -86,9 +116,21 @@ void NumberFormat::JSInternalFormat(
     return;
   }
 
+  v8::Local<v8::Number> number = args[1]->ToNumber();
+  if (number.IsEmpty()) {
+    // Exception is pending.
+    return;
+  }
+
+  // Spec treats -0 and +0 as 0.
+  double value = number->Value();
+  if (value == 0) {
+    value = 0;
+  }
+
   // ICU will handle actual NaN value properly and return NaN string.
   icu::UnicodeString result;
-  number_format->format(args[1]->NumberValue(), result);
+  number_format->format(value, result);
 
   args.GetReturnValue().Set(v8::String::New(
       reinterpret_cast<const uint16_t*>(result.getBuffer()), result.length()));
@@ -147,7 +189,7 @@ void NumberFormat::JSInternalParse(
 void NumberFormat::JSCreateNumberFormat(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
   if (args.Length() != 3 ||
-      !args[0]->IsString() ||
+      !args[0]->IsArray() ||
       !args[1]->IsObject() ||
       !args[2]->IsObject()) {
     v8::ThrowException(v8::Exception::Error(
@@ -155,6 +197,15 @@ void NumberFormat::JSCreateNumberFormat(
     return;
   }
 
+  std::string requested_locale;
+  NumberFormatOptions options;
+  if (!ResolveNumberFormatOptions(v8::Local<v8::Array>::Cast(args[0]),
+                                  args[1]->ToObject(),
+                                  &requested_locale,
+                                  &options)) {
+    return;
+  }
+
   v8::Isolate* isolate = args.GetIsolate();
   v8::Local<v8::ObjectTemplate> number_format_template =
       Utils::GetTemplate(isolate);
@@ -169,8 +220,8 @@ void NumberFormat::JSCreateNumberFormat(
   }
 
   // Set number formatter as internal field of the resulting JS object.
-  icu::DecimalFormat* number_format = InitializeNumberFormat(
-      args[0]->ToString(), args[1]->ToObject(), args[2]->ToObject());
+  icu::DecimalFormat* number_format =
+      InitializeNumberFormat(requested_locale, options, args[2]->ToObject());
 
   if (!number_format) {
     v8::ThrowException(v8::Exception::Error(v8::String::New(
@@ -179,13 +230,7 @@ void NumberFormat::JSCreateNumberFormat(
   } else {
     local_object->SetAlignedPointerInInternalField(0, number_format);
 
-    v8::TryCatch try_catch;
-    local_object->Set(v8::String::New("numberFormat"), v8::String::New("valid"));
-    if (try_catch.HasCaught()) {
-      v8::ThrowException(v8::Exception::Error(
-          v8::String::New("Internal error, couldn't set property.")));
-      return;
-    }
+    Utils::SetWrapperType(local_object, Utils::NUMBER_FORMAT_WRAPPER);
   }
 
   v8::Persistent<v8::Object> wrapper(isolate, local_object);
@@ -195,18 +240,155 @@ void NumberFormat::JSCreateNumberFormat(
   wrapper.ClearAndLeak();
 }
 
+// Verifies that the input is a well-formed ISO 4217 currency code.
+// Don't uppercase to test. It could convert invalid code into a valid one.
+// For example Eszett+P becomes SSP.
+static bool IsWellFormedCurrencyCode(const std::string& currency) {
+  if (currency.length() != 3) {
+    return false;
+  }
+
+  for (size_t i = 0; i < currency.length(); ++i) {
+    char c = currency[i];
+    if (!(c >= 'a' && c <= 'z') && !(c >= 'A' && c <= 'Z')) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Reads user options in the order ECMA-402 specifies, and resolves the
+// locale. Returns false with an exception pending on invalid options.
+static bool ResolveNumberFormatOptions(v8::Handle<v8::Array> requested_locales,
+                                       v8::Handle<v8::Object> user_options,
+                                       std::string* requested_locale,
+                                       NumberFormatOptions* options) {
+  static const char* const kStyleValues[] = {
+    "decimal", "percent", "currency", NULL
+  };
+  static const char* const kCurrencyDisplayValues[] = {
+    "code", "symbol", "name", NULL
+  };
+
+  OptionResolver resolver(user_options, "numberformat");
+  LocaleMatch match;
+  if (!resolver.ResolveLocale("numberformat", requested_locales, &match)) {
+    return false;
+  }
+
+  bool found = false;
+  if (!resolver.GetString(PropertyNames::STYLE, kStyleValues,
+                          &options->style, &found)) {
+    return false;
+  }
+
+  v8::Local<v8::Value> currency_value;
+  if (!resolver.Get(PropertyNames::CURRENCY, &currency_value)) {
+    return false;
+  }
+
+  std::string currency;
+  bool has_currency = !currency_value->IsUndefined();
+  if (has_currency) {
+    v8::TryCatch try_catch;
+    v8::Local<v8::String> currency_string = currency_value->ToString();
+    if (try_catch.HasCaught()) {
+      try_catch.ReThrow();
+      return false;
+    }
+
+    v8::String::Utf8Value utf8_currency(currency_string);
+    currency.assign(*utf8_currency, utf8_currency.length());
+    if (!IsWellFormedCurrencyCode(currency)) {
+      v8::ThrowException(v8::Exception::RangeError(v8::String::Concat(
+          v8::String::New("Invalid currency code: "), currency_string)));
+      return false;
+    }
+  }
+
+  bool is_currency = options->style == "currency";
+  if (is_currency && !has_currency) {
+    v8::ThrowException(v8::Exception::TypeError(v8::String::New(
+        "Currency code is required with currency style.")));
+    return false;
+  }
+
+  if (!resolver.GetString(PropertyNames::CURRENCY_DISPLAY,
+                          kCurrencyDisplayValues,
+                          &options->currency_display, &found)) {
+    return false;
+  }
+
+  if (is_currency) {
+    for (size_t i = 0; i < currency.length(); ++i) {
+      if (currency[i] >= 'a' && currency[i] <= 'z') {
+        currency[i] -= 'a' - 'A';
+      }
+    }
+    options->currency = currency;
+  }
+
+  // Digit ranges.
+  if (!resolver.GetNumber(PropertyNames::MINIMUM_INTEGER_DIGITS, 1, 21, 1,
+                          &options->minimum_integer_digits) ||
+      !resolver.GetNumber(PropertyNames::MINIMUM_FRACTION_DIGITS, 0, 20, 0,
+                          &options->minimum_fraction_digits) ||
+      !resolver.GetNumber(PropertyNames::MAXIMUM_FRACTION_DIGITS,
+                          options->minimum_fraction_digits, 20, 3,
+                          &options->maximum_fraction_digits)) {
+    return false;
+  }
+
+  // Significant digits are read twice, as the spec does: once to see if
+  // they are present, and once more to validate them.
+  v8::Local<v8::Value> mnsd;
+  v8::Local<v8::Value> mxsd;
+  if (!resolver.Get(PropertyNames::MINIMUM_SIGNIFICANT_DIGITS, &mnsd) ||
+      !resolver.Get(PropertyNames::MAXIMUM_SIGNIFICANT_DIGITS, &mxsd)) {
+    return false;
+  }
+
+  if (!mnsd->IsUndefined() || !mxsd->IsUndefined()) {
+    options->has_significant_digits = true;
+    if (!resolver.GetNumber(PropertyNames::MINIMUM_SIGNIFICANT_DIGITS,
+                            1, 21, 0,
+                            &options->minimum_significant_digits) ||
+        !resolver.GetNumber(PropertyNames::MAXIMUM_SIGNIFICANT_DIGITS,
+                            options->minimum_significant_digits, 21, 21,
+                            &options->maximum_significant_digits)) {
+      return false;
+    }
+  }
+
+  if (!resolver.GetBoolean(PropertyNames::USE_GROUPING,
+                           &options->use_grouping, &found)) {
+    return false;
+  }
+
+  // ICU prefers numbering system to be passed as -u-nu- extension.
+  requested_locale->assign(match.locale);
+  ExtensionMap extension;
+  OptionResolver::ParseExtension(match.extension, &extension);
+  ExtensionMap::const_iterator it = extension.find("nu");
+  if (it != extension.end() && !it->second.empty()) {
+    requested_locale->append("-u-nu-").append(it->second);
+  }
+
+  return true;
+}
+
 static icu::DecimalFormat* InitializeNumberFormat(
-    v8::Handle<v8::String> locale,
-    v8::Handle<v8::Object> options,
+    const std::string& locale,
+    const NumberFormatOptions& options,
     v8::Handle<v8::Object> resolved) {
   // Convert BCP47 into ICU locale format.
   UErrorCode status = U_ZERO_ERROR;
   icu::Locale icu_locale;
   char icu_result[ULOC_FULLNAME_CAPACITY];
   int icu_length = 0;
-  v8::String::AsciiValue bcp47_locale(locale);
-  if (bcp47_locale.length() != 0) {
-    uloc_forLanguageTag(*bcp47_locale, icu_result, ULOC_FULLNAME_CAPACITY,
+  if (!locale.empty()) {
+    uloc_forLanguageTag(locale.c_str(), icu_result, ULOC_FULLNAME_CAPACITY,
                         &icu_length, &status);
     if (U_FAILURE(status) || icu_length == 0) {
       return NULL;
@@ -220,66 +402,66 @@ static icu::DecimalFormat* InitializeNumberFormat(
     // Remove extensions and try again.
     icu::Locale no_extension_locale(icu_locale.getBaseName());
     number_format = CreateICUNumberFormat(no_extension_locale, options);
+    if (!number_format) {
+      return NULL;
+    }
 
     // Set resolved settings (pattern, numbering system).
-    SetResolvedSettings(no_extension_locale, number_format, resolved);
+    SetResolvedSettings(no_extension_locale, number_format, options,
+                        resolved);
   } else {
-    SetResolvedSettings(icu_locale, number_format, resolved);
+    SetResolvedSettings(icu_locale, number_format, options, resolved);
   }
 
+  resolved->Set(PropertyNames::Get(PropertyNames::REQUESTED_LOCALE),
+                v8::String::New(locale.c_str()));
+
   return number_format;
 }
 
 static icu::DecimalFormat* CreateICUNumberFormat(
-    const icu::Locale& icu_locale, v8::Handle<v8::Object> options) {
+    const icu::Locale& icu_locale, const NumberFormatOptions& options) {
   // Make formatter from options. Numbering system is added
   // to the locale as Unicode extension (if it was specified at all).
   UErrorCode status = U_ZERO_ERROR;
   icu::DecimalFormat* number_format = NULL;
-  icu::UnicodeString style;
-  icu::UnicodeString currency;
-  if (Utils::ExtractStringSetting(options, "style", &style)) {
-    if (style == UNICODE_STRING_SIMPLE("currency")) {
-      Utils::ExtractStringSetting(options, "currency", &currency);
-
-      icu::UnicodeString display;
-      Utils::ExtractStringSetting(options, "currencyDisplay", &display);
+  if (options.style == "currency") {
+    const std::string& display = options.currency_display;
 #if (U_ICU_VERSION_MAJOR_NUM == 4) && (U_ICU_VERSION_MINOR_NUM <= 6)
-      icu::NumberFormat::EStyles style;
-      if (display == UNICODE_STRING_SIMPLE("code")) {
-        style = icu::NumberFormat::kIsoCurrencyStyle;
-      } else if (display == UNICODE_STRING_SIMPLE("name")) {
-        style = icu::NumberFormat::kPluralCurrencyStyle;
-      } else {
-        style = icu::NumberFormat::kCurrencyStyle;
-      }
+    icu::NumberFormat::EStyles style;
+    if (display == "code") {
+      style = icu::NumberFormat::kIsoCurrencyStyle;
+    } else if (display == "name") {
+      style = icu::NumberFormat::kPluralCurrencyStyle;
+    } else {
+      style = icu::NumberFormat::kCurrencyStyle;
+    }
 #else  // ICU version is 4.8 or above (we ignore versions below 4.0).
-      UNumberFormatStyle style;
-      if (display == UNICODE_STRING_SIMPLE("code")) {
-        style = UNUM_CURRENCY_ISO;
-      } else if (display == UNICODE_STRING_SIMPLE("name")) {
-        style = UNUM_CURRENCY_PLURAL;
-      } else {
-        style = UNUM_CURRENCY;
-      }
+    UNumberFormatStyle style;
+    if (display == "code") {
+      style = UNUM_CURRENCY_ISO;
+    } else if (display == "name") {
+      style = UNUM_CURRENCY_PLURAL;
+    } else {
+      style = UNUM_CURRENCY;
+    }
 #endif
 
-      number_format = static_cast<icu::DecimalFormat*>(
-          icu::NumberFormat::createInstance(icu_locale, style,  status));
-    } else if (style == UNICODE_STRING_SIMPLE("percent")) {
-      number_format = static_cast<icu::DecimalFormat*>(
-          icu::NumberFormat::createPercentInstance(icu_locale, status));
-      if (U_FAILURE(status)) {
-        delete number_format;
-        return NULL;
-      }
-      // Make sure 1.1% doesn't go into 2%.
-      number_format->setMinimumFractionDigits(1);
-    } else {
-      // Make a decimal instance by default.
-      number_format = static_cast<icu::DecimalFormat*>(
-          icu::NumberFormat::createInstance(icu_locale, status));
+    number_format = static_cast<icu::DecimalFormat*>(
+        icu::NumberFormat::createInstance(icu_locale, style,  status));
+  } else if (options.style == "percent") {
+    number_format = static_cast<icu::DecimalFormat*>(
+        icu::NumberFormat::createPercentInstance(icu_locale, status));
+    if (U_FAILURE(status)) {
+      delete number_format;
+      return NULL;
     }
+    // Make sure 1.1% doesn't go into 2%.
+    number_format->setMinimumFractionDigits(1);
+  } else {
+    // Make a decimal instance by default.
+    number_format = static_cast<icu::DecimalFormat*>(
+        icu::NumberFormat::createInstance(icu_locale, status));
   }
 
   if (U_FAILURE(status)) {
@@ -288,45 +470,27 @@ static icu::DecimalFormat* CreateICUNumberFormat(
   }
 
   // Set all options.
-  if (!currency.isEmpty()) {
-    number_format->setCurrency(currency.getBuffer(), status);
-  }
-
-  int32_t digits;
-  if (Utils::ExtractIntegerSetting(
-          options, "minimumIntegerDigits", &digits)) {
-    number_format->setMinimumIntegerDigits(digits);
-  }
-
-  if (Utils::ExtractIntegerSetting(
-          options, "minimumFractionDigits", &digits)) {
-    number_format->setMinimumFractionDigits(digits);
+  if (!options.currency.empty()) {
+    UChar currency[4];
+    Utils::AsciiToUChar(options.currency.c_str(),
+                        static_cast<int32_t>(options.currency.length()) + 1,
+                        currency, 4);
+    number_format->setCurrency(currency, status);
   }
 
-  if (Utils::ExtractIntegerSetting(
-          options, "maximumFractionDigits", &digits)) {
-    number_format->setMaximumFractionDigits(digits);
-  }
-
-  bool significant_digits_used = false;
-  if (Utils::ExtractIntegerSetting(
-          options, "minimumSignificantDigits", &digits)) {
-    number_format->setMinimumSignificantDigits(digits);
-    significant_digits_used = true;
-  }
+  number_format->setMinimumIntegerDigits(options.minimum_integer_digits);
+  number_format->setMinimumFractionDigits(options.minimum_fraction_digits);
+  number_format->setMaximumFractionDigits(options.maximum_fraction_digits);
 
-  if (Utils::ExtractIntegerSetting(
-          options, "maximumSignificantDigits", &digits)) {
-    number_format->setMaximumSignificantDigits(digits);
-    significant_digits_used = true;
+  if (options.has_significant_digits) {
+    number_format->setMinimumSignificantDigits(
+        options.minimum_significant_digits);
+    number_format->setMaximumSignificantDigits(
+        options.maximum_significant_digits);
   }
+  number_format->setSignificantDigitsUsed(options.has_significant_digits);
 
-  number_format->setSignificantDigitsUsed(significant_digits_used);
-
-  bool grouping;
-  if (Utils::ExtractBooleanSetting(options, "useGrouping", &grouping)) {
-    number_format->setGroupingUsed(grouping);
-  }
+  number_format->setGroupingUsed(options.use_grouping);
 
   // Set rounding mode.
   number_format->setRoundingMode(icu::DecimalFormat::kRoundHalfUp);
@@ -336,17 +500,29 @@ static icu::DecimalFormat* CreateICUNumberFormat(
 
 static void SetResolvedSettings(const icu::Locale& icu_locale,
                                 icu::DecimalFormat* number_format,
+                                const NumberFormatOptions& options,
                                 v8::Handle<v8::Object> resolved) {
+  resolved->Set(PropertyNames::Get(PropertyNames::STYLE),
+                v8::String::New(options.style.c_str()));
+
+  // We can't get information about number or currency style from ICU, so we
+  // assume user request was fulfilled.
+  if (options.style == "currency") {
+    resolved->Set(PropertyNames::Get(PropertyNames::CURRENCY_DISPLAY),
+                  v8::String::New(options.currency_display.c_str()));
+  }
+
+
   icu::UnicodeString pattern;
   number_format->toPattern(pattern);
-  resolved->Set(v8::String::New("pattern"),
+  resolved->Set(PropertyNames::Get(PropertyNames::PATTERN),
                 v8::String::New(reinterpret_cast<const uint16_t*>(
                     pattern.getBuffer()), pattern.length()));
 
   // Set resolved currency code in options.currency if not empty.
   icu::UnicodeString currency(number_format->getCurrency());
   if (!currency.isEmpty()) {
-    resolved->Set(v8::String::New("currency"),
+    resolved->Set(PropertyNames::Get(PropertyNames::CURRENCY),
                   v8::String::New(reinterpret_cast<const uint16_t*>(
                       currency.getBuffer()), currency.length()));
   }
@@ -359,31 +535,32 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
       icu::NumberingSystem::createInstance(icu_locale, status);
   if (U_SUCCESS(status)) {
     const char* ns = numbering_system->getName();
-    resolved->Set(v8::String::New("numberingSystem"), v8::String::New(ns));
+    resolved->Set(PropertyNames::Get(PropertyNames::NUMBERING_SYSTEM),
+                  v8::String::New(ns));
   } else {
-    resolved->Set(v8::String::New("numberingSystem"), v8::Undefined());
+    resolved->Set(PropertyNames::Get(PropertyNames::NUMBERING_SYSTEM),
+                  v8::Undefined());
   }
   delete numbering_system;
 
-  resolved->Set(v8::String::New("useGrouping"),
+  resolved->Set(PropertyNames::Get(PropertyNames::USE_GROUPING),
                 v8::Boolean::New(number_format->isGroupingUsed()));
 
-  resolved->Set(v8::String::New("minimumIntegerDigits"),
+  resolved->Set(PropertyNames::Get(PropertyNames::MINIMUM_INTEGER_DIGITS),
                 v8::Integer::New(number_format->getMinimumIntegerDigits()));
 
-  resolved->Set(v8::String::New("minimumFractionDigits"),
+  resolved->Set(PropertyNames::Get(PropertyNames::MINIMUM_FRACTION_DIGITS),
                 v8::Integer::New(number_format->getMinimumFractionDigits()));
 
-  resolved->Set(v8::String::New("maximumFractionDigits"),
+  resolved->Set(PropertyNames::Get(PropertyNames::MAXIMUM_FRACTION_DIGITS),
                 v8::Integer::New(number_format->getMaximumFractionDigits()));
 
-  if (resolved->HasOwnProperty(v8::String::New("minimumSignificantDigits"))) {
-    resolved->Set(v8::String::New("minimumSignificantDigits"), v8::Integer::New(
+  if (options.has_significant_digits) {
+    resolved->Set(PropertyNames::Get(PropertyNames::MINIMUM_SIGNIFICANT_DIGITS),
+                  v8::Integer::New(
         number_format->getMinimumSignificantDigits()));
-  }
-
-  if (resolved->HasOwnProperty(v8::String::New("maximumSignificantDigits"))) {
-    resolved->Set(v8::String::New("maximumSignificantDigits"), v8::Integer::New(
+    resolved->Set(PropertyNames::Get(PropertyNames::MAXIMUM_SIGNIFICANT_DIGITS),
+                  v8::Integer::New(
         number_format->getMaximumSignificantDigits()));
   }
 
@@ -393,10 +570,12 @@ static void SetResolvedSettings(const icu::Locale& icu_locale,
   uloc_toLanguageTag(
       icu_locale.getName(), result, ULOC_FULLNAME_CAPACITY, FALSE, &status);
   if (U_SUCCESS(status)) {
-    resolved->Set(v8::String::New("locale"), v8::String::New(result));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New(result));
   } else {
     // This would never happen, since we got the locale from ICU.
-    resolved->Set(v8::String::New("locale"), v8::String::New("und"));
+    resolved->Set(PropertyNames::Get(PropertyNames::LOCALE),
+                  v8::String::New("und"));
   }
 }
 
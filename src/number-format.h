@@ -40,7 +40,8 @@ class NumberFormat {
                                  v8::Persistent<v8::Object>* object,
                                  void* param);
 
-  // Formats number and returns corresponding string.
+  // Formats number and returns corresponding string. Value is converted to
+  // a number first.
   static void JSInternalFormat(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   // Parses a string and returns a number.
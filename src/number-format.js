@@ -16,36 +16,6 @@
 // each service. The build system combines them together into one
 // Intl namespace.
 
-/**
- * Verifies that the input is a well-formed ISO 4217 currency code.
- * Don't uppercase to test. It could convert invalid code into a valid one.
- * For example \u00DFP (Eszett+P) becomes SSP.
- */
-function isWellFormedCurrencyCode(currency) {
-  return typeof currency == "string" &&
-      currency.length == 3 &&
-      currency.match(/[^A-Za-z]/) == null;
-}
-
-
-/**
- * Returns the valid digit count for a property, or throws RangeError on
- * a value out of the range.
- */
-function getNumberOption(options, property, min, max, fallback) {
-  var value = options[property];
-  if (value !== undefined) {
-    value = Number(value);
-    if (isNaN(value) || value < min || value > max) {
-      throw new RangeError(property + ' value is out of range.');
-    }
-    return Math.floor(value);
-  }
-
-  return fallback;
-}
-
-
 /**
  * Initializes the given object so it's a valid NumberFormat instance.
  * Useful for subclassing.
@@ -57,93 +27,35 @@ function initializeNumberFormat(numberFormat, locales, options) {
     throw new TypeError('Trying to re-initialize NumberFormat object.');
   }
 
+  var requestedLocales = initializeLocaleList(locales);
+
   if (options === undefined) {
     options = {};
+  } else {
+    options = toObject(options);
   }
 
-  var getOption = getGetOption(options, 'numberformat');
-
-  var locale = resolveLocale('numberformat', locales, options);
-
-  var internalOptions = {};
-  defineWEProperty(internalOptions, 'style', getOption(
-    'style', 'string', ['decimal', 'percent', 'currency'], 'decimal'));
-
-  var currency = getOption('currency', 'string');
-  if (currency !== undefined && !isWellFormedCurrencyCode(currency)) {
-    throw new RangeError('Invalid currency code: ' + currency);
-  }
-
-  if (internalOptions.style === 'currency' && currency === undefined) {
-    throw new TypeError('Currency code is required with currency style.');
-  }
-
-  var currencyDisplay = getOption(
-      'currencyDisplay', 'string', ['code', 'symbol', 'name'], 'symbol');
-  if (internalOptions.style === 'currency') {
-    defineWEProperty(internalOptions, 'currency', currency.toUpperCase());
-    defineWEProperty(internalOptions, 'currencyDisplay', currencyDisplay);
-  }
-
-  // Digit ranges.
-  var mnid = getNumberOption(options, 'minimumIntegerDigits', 1, 21, 1);
-  defineWEProperty(internalOptions, 'minimumIntegerDigits', mnid);
-
-  var mnfd = getNumberOption(options, 'minimumFractionDigits', 0, 20, 0);
-  defineWEProperty(internalOptions, 'minimumFractionDigits', mnfd);
-
-  var mxfd = getNumberOption(options, 'maximumFractionDigits', mnfd, 20, 3);
-  defineWEProperty(internalOptions, 'maximumFractionDigits', mxfd);
-
-  var mnsd = options['minimumSignificantDigits'];
-  var mxsd = options['maximumSignificantDigits'];
-  if (mnsd !== undefined || mxsd !== undefined) {
-    mnsd = getNumberOption(options, 'minimumSignificantDigits', 1, 21, 0);
-    defineWEProperty(internalOptions, 'minimumSignificantDigits', mnsd);
-
-    mxsd = getNumberOption(options, 'maximumSignificantDigits', mnsd, 21, 21);
-    defineWEProperty(internalOptions, 'maximumSignificantDigits', mxsd);
-  }
-
-  // Grouping.
-  defineWEProperty(internalOptions, 'useGrouping', getOption(
-    'useGrouping', 'boolean', undefined, true));
-
-  // ICU prefers options to be passed using -u- extension key/values for
-  // number format, so we need to build that.
-  var extensionMap = parseExtension(locale.extension);
-  var extension = setOptions(options, extensionMap, NUMBER_FORMAT_KEY_MAP,
-                             getOption, internalOptions);
-
-  var requestedLocale = locale.locale + extension;
+  // Options are validated, and the locale resolved, natively in the same
+  // call that creates ICU formatter, in the order the spec defines.
   var resolved = Object.defineProperties({}, {
     currency: {writable: true},
     currencyDisplay: {writable: true},
     locale: {writable: true},
     maximumFractionDigits: {writable: true},
+    maximumSignificantDigits: {writable: true},
     minimumFractionDigits: {writable: true},
     minimumIntegerDigits: {writable: true},
+    minimumSignificantDigits: {writable: true},
     numberingSystem: {writable: true},
-    requestedLocale: {value: requestedLocale, writable: true},
-    style: {value: internalOptions.style, writable: true},
+    pattern: {writable: true},
+    requestedLocale: {writable: true},
+    style: {writable: true},
     useGrouping: {writable: true}
   });
-  if (internalOptions.hasOwnProperty('minimumSignificantDigits')) {
-    defineWEProperty(resolved, 'minimumSignificantDigits', undefined);
-  }
-  if (internalOptions.hasOwnProperty('maximumSignificantDigits')) {
-    defineWEProperty(resolved, 'maximumSignificantDigits', undefined);
-  }
-  var formatter = NativeJSCreateNumberFormat(requestedLocale,
-                                             internalOptions,
-                                             resolved);
 
-  // We can't get information about number or currency style from ICU, so we
-  // assume user request was fulfilled.
-  if (internalOptions.style === 'currency') {
-    Object.defineProperty(resolved, 'currencyDisplay', {value: currencyDisplay,
-                                                        writable: true});
-  }
+  var formatter = NativeJSCreateNumberFormat(requestedLocales,
+                                             options,
+                                             resolved);
 
   Object.defineProperty(numberFormat, 'formatter', {value: formatter});
   Object.defineProperty(numberFormat, 'resolved', {value: resolved});
@@ -209,12 +121,12 @@ function initializeNumberFormat(numberFormat, locales, options) {
                         format.resolved.currencyDisplay);
     }
 
-    if (format.resolved.hasOwnProperty('minimumSignificantDigits')) {
+    if (format.resolved.minimumSignificantDigits !== undefined) {
       defineWECProperty(result, 'minimumSignificantDigits',
                         format.resolved.minimumSignificantDigits);
     }
 
-    if (format.resolved.hasOwnProperty('maximumSignificantDigits')) {
+    if (format.resolved.maximumSignificantDigits !== undefined) {
       defineWECProperty(result, 'maximumSignificantDigits',
                         format.resolved.maximumSignificantDigits);
     }
@@ -250,15 +162,7 @@ function initializeNumberFormat(numberFormat, locales, options) {
  * NumberFormat.
  */
 function formatNumber(formatter, value) {
-  native function NativeJSInternalNumberFormat();
-
-  // Spec treats -0 and +0 as 0.
-  var number = Number(value);
-  if (number === -0) {
-    number = 0;
-  }
-
-  return NativeJSInternalNumberFormat(formatter.formatter, number);
+  return NativeJSInternalNumberFormat(formatter.formatter, value);
 }
 
 
@@ -272,5 +176,14 @@ function parseNumber(formatter, value) {
 }
 
 
-addBoundMethod(Intl.NumberFormat, 'format', formatNumber, 1);
+// Converts value to a number natively. Spec treats -0 and +0 as 0.
+native function NativeJSInternalNumberFormat();
+
+
+addBoundMethod(Intl.NumberFormat, 'format', NativeJSInternalNumberFormat, 1,
+               'formatter');
 addBoundMethod(Intl.NumberFormat, 'v8Parse', parseNumber, 1);
+
+
+exportService('number-format',
+              {constructor: Intl.NumberFormat, formatNumber: formatNumber});
@@ -0,0 +1,286 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/option-resolver.h"
+
+#include <math.h>
+
+#include "src/locale-matcher.h"
+#include "src/utils.h"
+#include "unicode/unistr.h"
+
+namespace v8_i18n {
+
+static bool IsAllowedValue(const std::string&, const char* const*);
+
+OptionResolver::OptionResolver(v8::Handle<v8::Object> options,
+                               const char* caller)
+    : options_(options),
+      caller_(caller) {
+}
+
+bool OptionResolver::Get(PropertyNames::Name name,
+                         v8::Local<v8::Value>* result) {
+  v8::TryCatch try_catch;
+  v8::Local<v8::Value> value = options_->Get(PropertyNames::Get(name));
+  if (try_catch.HasCaught()) {
+    try_catch.ReThrow();
+    return false;
+  }
+
+  *result = value;
+  return true;
+}
+
+bool OptionResolver::GetString(PropertyNames::Name name,
+                               const char* const* values,
+                               std::string* result,
+                               bool* found) {
+  v8::Local<v8::Value> value;
+  if (!Get(name, &value)) {
+    return false;
+  }
+
+  *found = !value->IsUndefined();
+  if (!*found) {
+    return true;
+  }
+
+  v8::TryCatch try_catch;
+  v8::Local<v8::String> string = value->ToString();
+  if (try_catch.HasCaught()) {
+    try_catch.ReThrow();
+    return false;
+  }
+
+  v8::String::Utf8Value utf8_value(string);
+  std::string converted(*utf8_value, utf8_value.length());
+  if (values && !IsAllowedValue(converted, values)) {
+    ThrowOutOfRange(name, string);
+    return false;
+  }
+
+  result->swap(converted);
+  return true;
+}
+
+bool OptionResolver::GetUnicodeString(PropertyNames::Name name,
+                                      icu::UnicodeString* result,
+                                      bool* found) {
+  v8::Local<v8::Value> value;
+  if (!Get(name, &value)) {
+    return false;
+  }
+
+  *found = !value->IsUndefined();
+  if (!*found) {
+    return true;
+  }
+
+  v8::TryCatch try_catch;
+  v8::Local<v8::String> string = value->ToString();
+  if (try_catch.HasCaught()) {
+    try_catch.ReThrow();
+    return false;
+  }
+
+  return Utils::V8StringToUnicodeString(string, result);
+}
+
+bool OptionResolver::GetBoolean(PropertyNames::Name name,
+                                bool* result,
+                                bool* found) {
+  v8::Local<v8::Value> value;
+  if (!Get(name, &value)) {
+    return false;
+  }
+
+  *found = !value->IsUndefined();
+  if (*found) {
+    // ToBoolean never calls into JavaScript.
+    *result = value->BooleanValue();
+  }
+
+  return true;
+}
+
+bool OptionResolver::GetNumber(PropertyNames::Name name,
+                               int32_t min,
+                               int32_t max,
+                               int32_t fallback,
+                               int32_t* result) {
+  v8::Local<v8::Value> value;
+  if (!Get(name, &value)) {
+    return false;
+  }
+
+  if (value->IsUndefined()) {
+    *result = fallback;
+    return true;
+  }
+
+  v8::TryCatch try_catch;
+  double number = value->NumberValue();
+  if (try_catch.HasCaught()) {
+    try_catch.ReThrow();
+    return false;
+  }
+
+  // NaN fails both comparisons.
+  if (!(number >= min && number <= max)) {
+    v8::ThrowException(v8::Exception::RangeError(v8::String::Concat(
+        PropertyNames::Get(name),
+        v8::String::New(" value is out of range."))));
+    return false;
+  }
+
+  *result = static_cast<int32_t>(floor(number));
+  return true;
+}
+
+bool OptionResolver::GetBinary(PropertyNames::Name name,
+                               std::vector<uint8_t>* result,
+                               bool* found) {
+  v8::Local<v8::Value> value;
+  if (!Get(name, &value)) {
+    return false;
+  }
+
+  *found = !value->IsUndefined();
+  if (!*found) {
+    return true;
+  }
+
+  v8::Local<v8::Object> array;
+  if (value->IsArrayBuffer()) {
+    v8::Local<v8::ArrayBuffer> buffer = v8::Local<v8::ArrayBuffer>::Cast(value);
+    array = v8::Uint8Array::New(buffer, 0, buffer->ByteLength());
+  } else if (value->IsUint8Array()) {
+    array = value->ToObject();
+  } else {
+    v8::ThrowException(v8::Exception::TypeError(v8::String::Concat(
+        PropertyNames::Get(name),
+        v8::String::New(" has to be an ArrayBuffer or an Uint8Array."))));
+    return false;
+  }
+
+  const uint8_t* data = static_cast<const uint8_t*>(
+      array->GetIndexedPropertiesExternalArrayData());
+  int32_t length = array->GetIndexedPropertiesExternalArrayDataLength();
+  if (data && length > 0) {
+    result->assign(data, data + length);
+  } else {
+    result->clear();
+  }
+
+  return true;
+}
+
+bool OptionResolver::ResolveLocale(const std::string& service,
+                                   v8::Handle<v8::Array> requested,
+                                   LocaleMatch* match) {
+  static const char* const kMatcherValues[] = {"lookup", "best fit", NULL};
+  std::string matcher_name("best fit");
+  bool found = false;
+  if (!GetString(PropertyNames::LOCALE_MATCHER, kMatcherValues,
+                 &matcher_name, &found)) {
+    return false;
+  }
+
+  LocaleMatcher* matcher = LocaleMatcher::Get(service);
+  if (!matcher) {
+    v8::ThrowException(v8::Exception::Error(
+        v8::String::New("Internal error, wrong service type.")));
+    return false;
+  }
+
+  std::vector<std::string> tags;
+  for (unsigned int i = 0; i < requested->Length(); ++i) {
+    // Tags are canonicalized, so they are plain ASCII.
+    v8::String::AsciiValue tag(requested->Get(i));
+    if (*tag == NULL) {
+      continue;
+    }
+    tags.push_back(std::string(*tag, tag.length()));
+  }
+
+  if (matcher_name == "lookup") {
+    *match = matcher->Lookup(tags);
+  } else {
+    *match = matcher->BestFit(tags);
+  }
+
+  return true;
+}
+
+// static
+void OptionResolver::ParseExtension(const std::string& extension,
+                                    ExtensionMap* result) {
+  result->clear();
+
+  // Expect -u-key-value... input, but don't throw.
+  if (extension.compare(0, 3, "-u-") != 0) {
+    return;
+  }
+
+  // Key is {2}alphanum, value is {3,8}alphanum.
+  // Some keys may not have explicit values (booleans).
+  std::string key;
+  size_t start = 3;
+  while (start <= extension.length()) {
+    size_t end = extension.find('-', start);
+    if (end == std::string::npos) {
+      end = extension.length();
+    }
+
+    size_t length = end - start;
+    if (length == 2) {
+      key = extension.substr(start, length);
+      (*result)[key] = "";
+    } else if (length >= 3 && length <= 8 && !key.empty()) {
+      (*result)[key] = extension.substr(start, length);
+      key.clear();
+    } else {
+      // There is a value that's too long, or that doesn't have a key.
+      result->clear();
+      return;
+    }
+
+    start = end + 1;
+  }
+}
+
+void OptionResolver::ThrowOutOfRange(PropertyNames::Name name,
+                                     v8::Handle<v8::String> value) {
+  v8::Local<v8::String> message = v8::String::Concat(
+      v8::String::New("Value "), value);
+  message = v8::String::Concat(message, v8::String::New(" out of range for "));
+  message = v8::String::Concat(message, v8::String::New(caller_));
+  message = v8::String::Concat(
+      message, v8::String::New(" options property "));
+  message = v8::String::Concat(message, PropertyNames::Get(name));
+  v8::ThrowException(v8::Exception::RangeError(message));
+}
+
+static bool IsAllowedValue(const std::string& value,
+                           const char* const* values) {
+  for (; *values; ++values) {
+    if (value == *values) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace v8_i18n
@@ -0,0 +1,103 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef V8_I18N_SRC_OPTION_RESOLVER_H_
+#define V8_I18N_SRC_OPTION_RESOLVER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/property-names.h"
+#include "unicode/uversion.h"
+#include "v8/include/v8.h"
+
+namespace U_ICU_NAMESPACE {
+class UnicodeString;
+}
+
+namespace v8_i18n {
+
+struct LocaleMatch;
+
+// Unicode extension keys mapped to their values. Keys without a value,
+// like kn in -u-kn, map to empty string.
+typedef std::map<std::string, std::string> ExtensionMap;
+
+// Reads constructor options natively, with the coercions and range checks
+// of GetOption and GetNumberOption from ECMA-402. Options are read once,
+// in the order the caller asks for them, so getters observe the order
+// the spec requires.
+// Methods return false, with an exception pending, if a getter or
+// a conversion throws, or if the value is out of range.
+class OptionResolver {
+ public:
+  // |caller| is the service name used in error messages.
+  OptionResolver(v8::Handle<v8::Object> options, const char* caller);
+
+  // Reads a string option. |values| is a NULL terminated list of allowed
+  // values, or NULL if any value is allowed. |result| is left untouched,
+  // and |found| set to false, if the option is undefined.
+  bool GetString(PropertyNames::Name name,
+                 const char* const* values,
+                 std::string* result,
+                 bool* found);
+
+  // Reads a string option that isn't limited to ASCII, like rules.
+  bool GetUnicodeString(PropertyNames::Name name,
+                        icu::UnicodeString* result,
+                        bool* found);
+
+  // Reads a boolean option.
+  bool GetBoolean(PropertyNames::Name name, bool* result, bool* found);
+
+  // Reads a number option in [min, max] range, rounded down. Sets |result|
+  // to |fallback| if the option is undefined.
+  bool GetNumber(PropertyNames::Name name,
+                 int32_t min,
+                 int32_t max,
+                 int32_t fallback,
+                 int32_t* result);
+
+  // Reads an ArrayBuffer or Uint8Array option and copies its bytes.
+  // Throws TypeError for other values.
+  bool GetBinary(PropertyNames::Name name,
+                 std::vector<uint8_t>* result,
+                 bool* found);
+
+  // Reads an option without conversion.
+  bool Get(PropertyNames::Name name, v8::Local<v8::Value>* result);
+
+  // Reads localeMatcher option and matches canonicalized |requested|
+  // locales against the locales of |service|.
+  bool ResolveLocale(const std::string& service,
+                     v8::Handle<v8::Array> requested,
+                     LocaleMatch* match);
+
+  // Parses Unicode extension into key - value map. Leaves the map empty if
+  // the extension is invalid. Values are not validated.
+  static void ParseExtension(const std::string& extension,
+                             ExtensionMap* result);
+
+ private:
+  // Throws RangeError for a value out of the allowed list.
+  void ThrowOutOfRange(PropertyNames::Name name, v8::Handle<v8::String> value);
+
+  v8::Handle<v8::Object> options_;
+  const char* caller_;
+};
+
+}  // namespace v8_i18n
+
+#endif  // V8_I18N_SRC_OPTION_RESOLVER_H_
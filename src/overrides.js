@@ -17,13 +17,14 @@
 // Intl namespace.
 
 
-// Save references to Intl objects and methods we use, for added security.
-var savedObjects = {
-  'collator': Intl.Collator,
-  'numberformat': Intl.NumberFormat,
-  'dateformatall': Intl.DateTimeFormat,
-  'dateformatdate': Intl.DateTimeFormat,
-  'dateformattime': Intl.DateTimeFormat
+// Services that implement the overrides. Constructors and methods we use
+// come from what the services exported, not from Intl, for added security.
+var overrideServices = {
+  'collator': 'collator',
+  'numberformat': 'number-format',
+  'dateformatall': 'date-format',
+  'dateformatdate': 'date-format',
+  'dateformattime': 'date-format'
 };
 
 
@@ -38,19 +39,183 @@ var defaultObjects = {
 };
 
 
+/**
+ * Maximum number of instances created with explicit locales or options that
+ * we keep around.
+ */
+var SERVICE_CACHE_SIZE = 32;
+
+
+/**
+ * Instances created with explicit locales or options, keyed by the
+ * serialized arguments. Entries form a doubly linked list, most recently
+ * used first, so the least recently used one can be dropped in constant time.
+ */
+var serviceCache = {
+  entries: Object.create(null),
+  head: null,
+  tail: null,
+  size: 0
+};
+
+
+/**
+ * Appends a primitive value to the cache key. Type and length prefixes keep
+ * keys of different arguments apart.
+ */
+function appendToServiceCacheKey(key, value) {
+  var string = String(value);
+  return key + '|' + (typeof value).charAt(0) + string.length + ':' + string;
+}
+
+
+/**
+ * Returns the cache key for the given arguments, or undefined if they can't
+ * be serialized without observable side effects, e.g. when they have
+ * accessors or objects that the constructor would convert. Such instances
+ * are not cached.
+ */
+function serviceCacheKey(service, locales, options) {
+  var key = service;
+
+  if (typeof locales === 'string') {
+    key = appendToServiceCacheKey(key, locales);
+  } else if (locales !== undefined) {
+    if (!Array.isArray(locales)) {
+      return undefined;
+    }
+    key += '|a' + locales.length;
+    for (var i = 0; i < locales.length; ++i) {
+      var element = Object.getOwnPropertyDescriptor(locales, i);
+      if (element === undefined || typeof element.value !== 'string') {
+        return undefined;
+      }
+      key = appendToServiceCacheKey(key, element.value);
+    }
+  }
+
+  if (options === undefined) {
+    return key;
+  }
+
+  if (options === null || typeof options !== 'object' ||
+      Object.getPrototypeOf(options) !== Object.prototype) {
+    return undefined;
+  }
+
+  var names = Object.getOwnPropertyNames(options).sort();
+  key += '|o' + names.length;
+  for (var i = 0; i < names.length; ++i) {
+    var property = Object.getOwnPropertyDescriptor(options, names[i]);
+    var value = property.value;
+    if (property.get !== undefined || property.set !== undefined ||
+        (value !== null && typeof value === 'object') ||
+        typeof value === 'function') {
+      return undefined;
+    }
+    key = appendToServiceCacheKey(key, names[i]);
+    key = appendToServiceCacheKey(key, value);
+  }
+
+  return key;
+}
+
+
+/**
+ * Moves the cache entry to the front of the list.
+ */
+function touchServiceCacheEntry(entry) {
+  if (serviceCache.head === entry) {
+    return;
+  }
+
+  // Unlink.
+  if (entry.previous !== null) {
+    entry.previous.next = entry.next;
+  }
+  if (entry.next !== null) {
+    entry.next.previous = entry.previous;
+  }
+  if (serviceCache.tail === entry) {
+    serviceCache.tail = entry.previous;
+  }
+
+  // Link as the first entry.
+  entry.previous = null;
+  entry.next = serviceCache.head;
+  if (serviceCache.head !== null) {
+    serviceCache.head.previous = entry;
+  }
+  serviceCache.head = entry;
+  if (serviceCache.tail === null) {
+    serviceCache.tail = entry;
+  }
+}
+
+
+/**
+ * Adds new instance to the cache, dropping the least recently used one
+ * if the cache is full.
+ */
+function addServiceCacheEntry(key, instance) {
+  if (serviceCache.size === SERVICE_CACHE_SIZE) {
+    var last = serviceCache.tail;
+    serviceCache.tail = last.previous;
+    serviceCache.tail.next = null;
+    delete serviceCache.entries[last.key];
+    serviceCache.size--;
+  }
+
+  var entry = {key: key, instance: instance, previous: null, next: null};
+  serviceCache.entries[key] = entry;
+  serviceCache.size++;
+  touchServiceCacheEntry(entry);
+}
+
+
 /**
  * Returns cached or newly created instance of a given service.
- * We cache only default instances (where no locales or options are provided).
+ * Default instances (where no locales or options are provided) are kept
+ * for good. Instances with explicit arguments are kept in a bounded LRU
+ * cache, keyed by the serialized arguments.
+ * If required and defaults are specified, options are completed by
+ * toDateTimeOptions before a new date format is created.
  */
-function cachedOrNewService(service, locales, options, defaults) {
-  var useOptions = (defaults === undefined) ? options : defaults;
+function cachedOrNewService(service, locales, options, required, defaults) {
   if (locales === undefined && options === undefined) {
     if (defaultObjects[service] === undefined) {
-      defaultObjects[service] = new savedObjects[service](locales, useOptions);
+      defaultObjects[service] = newService(
+          service, locales, options, required, defaults);
     }
     return defaultObjects[service];
   }
-  return new savedObjects[service](locales, useOptions);
+
+  var key = serviceCacheKey(service, locales, options);
+  if (key === undefined) {
+    return newService(service, locales, options, required, defaults);
+  }
+
+  var entry = serviceCache.entries[key];
+  if (entry !== undefined) {
+    touchServiceCacheEntry(entry);
+    return entry.instance;
+  }
+
+  var instance = newService(service, locales, options, required, defaults);
+  addServiceCacheEntry(key, instance);
+  return instance;
+}
+
+
+/**
+ * Creates new instance of a given service.
+ */
+function newService(service, locales, options, required, defaults) {
+  var exports = loadService(overrideServices[service]);
+  if (required !== undefined) {
+    options = exports.toDateTimeOptions(options, required, defaults);
+  }
+  return new exports.constructor(locales, options);
 }
 
 
@@ -71,7 +236,7 @@ Object.defineProperty(String.prototype, 'localeCompare', {
     var locales = arguments[1];
     var options = arguments[2];
     var collator = cachedOrNewService('collator', locales, options);
-    return compare(collator, this, that);
+    return loadService('collator').compare(collator, this, that);
   },
   writable: true,
   configurable: true,
@@ -97,7 +262,7 @@ Object.defineProperty(Number.prototype, 'toLocaleString', {
     var locales = arguments[0];
     var options = arguments[1];
     var numberFormat = cachedOrNewService('numberformat', locales, options);
-    return formatNumber(numberFormat, this);
+    return loadService('number-format').formatNumber(numberFormat, this);
   },
   writable: true,
   configurable: true,
@@ -118,12 +283,10 @@ function toLocaleDateTime(date, locales, options, required, defaults, service) {
     return 'Invalid Date';
   }
 
-  var internalOptions = toDateTimeOptions(options, required, defaults);
-
   var dateFormat =
-      cachedOrNewService(service, locales, options, internalOptions);
+      cachedOrNewService(service, locales, options, required, defaults);
 
-  return formatDate(dateFormat, date);
+  return loadService('date-format').formatDate(dateFormat, date);
 }
 
 
@@ -0,0 +1,62 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/property-names.h"
+
+#include "src/isolate-data.h"
+
+namespace v8_i18n {
+
+static const char* const kPropertyNames[] = {
+#define PROPERTY_NAME_STRING(name, string) string,
+  PROPERTY_NAME_LIST(PROPERTY_NAME_STRING)
+#undef PROPERTY_NAME_STRING
+};
+
+struct NameTable {
+  v8::Persistent<v8::String> names[PropertyNames::NAME_COUNT];
+};
+
+static void DeleteNameTable(v8::Isolate* isolate, void* value) {
+  NameTable* table = static_cast<NameTable*>(value);
+  for (int i = 0; i < PropertyNames::NAME_COUNT; ++i) {
+    table->names[i].Dispose(isolate);
+  }
+  delete table;
+}
+
+static NameTable* GetNameTable(v8::Isolate* isolate) {
+  IsolateData* data = IsolateData::Get(isolate);
+  NameTable* table =
+      static_cast<NameTable*>(data->Get(IsolateData::PROPERTY_NAMES));
+  if (!table) {
+    table = new NameTable();
+    data->Set(IsolateData::PROPERTY_NAMES, table, &DeleteNameTable);
+  }
+  return table;
+}
+
+// static
+v8::Local<v8::String> PropertyNames::Get(Name name) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::Persistent<v8::String>& handle = GetNameTable(isolate)->names[name];
+
+  if (handle.IsEmpty()) {
+    handle.Reset(isolate, v8::String::NewSymbol(kPropertyNames[name]));
+  }
+
+  return v8::Local<v8::String>::New(isolate, handle);
+}
+
+}  // namespace v8_i18n
@@ -0,0 +1,88 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef V8_I18N_SRC_PROPERTY_NAMES_H_
+#define V8_I18N_SRC_PROPERTY_NAMES_H_
+
+#include "v8/include/v8.h"
+
+namespace v8_i18n {
+
+// Property names natives read from options and write to resolved objects.
+#define PROPERTY_NAME_LIST(V) \
+  V(BINARY_RULES, "binaryRules") \
+  V(CALENDAR, "calendar") \
+  V(CASE_FIRST, "caseFirst") \
+  V(COLLATION, "collation") \
+  V(CURRENCY, "currency") \
+  V(CURRENCY_DISPLAY, "currencyDisplay") \
+  V(DAY, "day") \
+  V(ERA, "era") \
+  V(EXTENSION, "extension") \
+  V(FORMAT_MATCHER, "formatMatcher") \
+  V(HITS, "hits") \
+  V(HOUR, "hour") \
+  V(HOUR12, "hour12") \
+  V(IGNORE_PUNCTUATION, "ignorePunctuation") \
+  V(LOCALE, "locale") \
+  V(LOCALE_MATCHER, "localeMatcher") \
+  V(MAXIMUM_FRACTION_DIGITS, "maximumFractionDigits") \
+  V(MAXIMUM_SIGNIFICANT_DIGITS, "maximumSignificantDigits") \
+  V(MINIMUM_FRACTION_DIGITS, "minimumFractionDigits") \
+  V(MINIMUM_INTEGER_DIGITS, "minimumIntegerDigits") \
+  V(MINIMUM_SIGNIFICANT_DIGITS, "minimumSignificantDigits") \
+  V(MINUTE, "minute") \
+  V(MISSES, "misses") \
+  V(MONTH, "month") \
+  V(NUMBERING_SYSTEM, "numberingSystem") \
+  V(NUMERIC, "numeric") \
+  V(PATTERN, "pattern") \
+  V(POSITION, "position") \
+  V(REQUESTED_LOCALE, "requestedLocale") \
+  V(RULES, "rules") \
+  V(SECOND, "second") \
+  V(SENSITIVITY, "sensitivity") \
+  V(STRENGTH, "strength") \
+  V(STYLE, "style") \
+  V(TIME_ZONE, "timeZone") \
+  V(TIME_ZONE_NAME, "timeZoneName") \
+  V(TYPE, "type") \
+  V(USAGE, "usage") \
+  V(USE_GROUPING, "useGrouping") \
+  V(V8_BINARY_RULES, "v8BinaryRules") \
+  V(V8_RULES, "v8Rules") \
+  V(WEEKDAY, "weekday") \
+  V(YEAR, "year")
+
+class PropertyNames {
+ public:
+  enum Name {
+#define DECLARE_PROPERTY_NAME(name, string) name,
+    PROPERTY_NAME_LIST(DECLARE_PROPERTY_NAME)
+#undef DECLARE_PROPERTY_NAME
+    NAME_COUNT
+  };
+
+  // Returns internalized |name| for the current isolate. Strings are
+  // created on first use, so property lookups don't allocate a new string
+  // and hash it every time.
+  static v8::Local<v8::String> Get(Name name);
+
+ private:
+  PropertyNames() {}
+};
+
+}  // namespace v8_i18n
+
+#endif  // V8_I18N_SRC_PROPERTY_NAMES_H_
@@ -16,6 +16,7 @@
 
 #include <string.h>
 
+#include "src/isolate-data.h"
 #include "unicode/unistr.h"
 
 namespace v8_i18n {
@@ -31,24 +32,31 @@ void Utils::StrNCopy(char* dest, int length, const char* src) {
 // static
 bool Utils::V8StringToUnicodeString(const v8::Handle<v8::Value>& input,
 				    icu::UnicodeString* output) {
-  v8::String::Utf8Value utf8_value(input);
+  v8::Local<v8::String> string = input->ToString();
+  if (string.IsEmpty()) return false;
 
-  if (*utf8_value == NULL) return false;
+  // Write UTF-16 straight into the UnicodeString buffer, avoiding the
+  // round trip through UTF-8.
+  int length = string->Length();
+  UChar* buffer = output->getBuffer(length);
+  if (!buffer) return false;
 
-  output->setTo(icu::UnicodeString::fromUTF8(*utf8_value));
+  string->Write(reinterpret_cast<uint16_t*>(buffer), 0, length,
+                v8::String::NO_NULL_TERMINATION);
+  output->releaseBuffer(length);
 
   return true;
 }
 
 // static
 bool Utils::ExtractStringSetting(const v8::Handle<v8::Object>& settings,
-                                 const char* setting,
+                                 PropertyNames::Name setting,
                                  icu::UnicodeString* result) {
-  if (!setting || !result) return false;
+  if (!result) return false;
 
   v8::HandleScope handle_scope;
   v8::TryCatch try_catch;
-  v8::Handle<v8::Value> value = settings->Get(v8::String::New(setting));
+  v8::Handle<v8::Value> value = settings->Get(PropertyNames::Get(setting));
   if (try_catch.HasCaught()) {
     return false;
   }
@@ -62,13 +70,13 @@ bool Utils::ExtractStringSetting(const v8::Handle<v8::Object>& settings,
 
 // static
 bool Utils::ExtractIntegerSetting(const v8::Handle<v8::Object>& settings,
-                                  const char* setting,
+                                  PropertyNames::Name setting,
                                   int32_t* result) {
-  if (!setting || !result) return false;
+  if (!result) return false;
 
   v8::HandleScope handle_scope;
   v8::TryCatch try_catch;
-  v8::Handle<v8::Value> value = settings->Get(v8::String::New(setting));
+  v8::Handle<v8::Value> value = settings->Get(PropertyNames::Get(setting));
   if (try_catch.HasCaught()) {
     return false;
   }
@@ -83,13 +91,13 @@ bool Utils::ExtractIntegerSetting(const v8::Handle<v8::Object>& settings,
 
 // static
 bool Utils::ExtractBooleanSetting(const v8::Handle<v8::Object>& settings,
-                                  const char* setting,
+                                  PropertyNames::Name setting,
                                   bool* result) {
-  if (!setting || !result) return false;
+  if (!result) return false;
 
   v8::HandleScope handle_scope;
   v8::TryCatch try_catch;
-  v8::Handle<v8::Value> value = settings->Get(v8::String::New(setting));
+  v8::Handle<v8::Value> value = settings->Get(PropertyNames::Get(setting));
   if (try_catch.HasCaught()) {
     return false;
   }
@@ -122,17 +130,83 @@ void Utils::AsciiToUChar(const char* source,
 }
 
 // static
-// Chrome Linux doesn't like static initializers in class, so we create
-// template on demand.
-v8::Local<v8::ObjectTemplate> Utils::GetTemplate(v8::Isolate* isolate) {
-  static v8::Persistent<v8::ObjectTemplate> icu_template;
+v8::Local<v8::Int32Array> Utils::NewInt32Array(const int32_t* data,
+                                               int32_t length) {
+  v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(length * sizeof(int32_t));
+  v8::Local<v8::Int32Array> array = v8::Int32Array::New(buffer, 0, length);
 
-  if (icu_template.IsEmpty()) {
-    v8::Local<v8::ObjectTemplate> raw_template(v8::ObjectTemplate::New());
+  // Typed arrays keep their elements in external array data, so we can
+  // copy the whole block at once instead of setting elements one by one.
+  if (length > 0) {
+    memcpy(array->GetIndexedPropertiesExternalArrayData(),
+           data, length * sizeof(int32_t));
+  }
+
+  return array;
+}
+
+// static
+v8::Local<v8::Uint8Array> Utils::NewUint8Array(const uint8_t* data,
+                                               int32_t length) {
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(length);
+  v8::Local<v8::Uint8Array> array = v8::Uint8Array::New(buffer, 0, length);
+
+  if (length > 0) {
+    memcpy(array->GetIndexedPropertiesExternalArrayData(), data, length);
+  }
+
+  return array;
+}
+
+// static
+std::string Utils::BinaryKey(const uint8_t* data, uint32_t length) {
+  uint64_t digest = 14695981039346656037ULL;
+  for (uint32_t i = 0; i < length; ++i) {
+    digest = (digest ^ data[i]) * 1099511628211ULL;
+  }
+
+  std::string key("binary/");
+  key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+  key.append(reinterpret_cast<const char*>(&digest), sizeof(digest));
+  return key;
+}
+
+// Most internal fields a wrapper needs, not counting the type tag.
+static const int kMaxWrapperFields = 5;
+
+// Object templates of one isolate, indexed by the number of internal
+// fields for the ICU object and its additional data.
+struct WrapperTemplates {
+  v8::Persistent<v8::ObjectTemplate> templates[kMaxWrapperFields + 1];
+};
 
-    // Set aside internal field for ICU class.
-    raw_template->SetInternalFieldCount(1);
+static void DeleteWrapperTemplates(v8::Isolate* isolate, void* value) {
+  WrapperTemplates* wrapper_templates = static_cast<WrapperTemplates*>(value);
+  for (int i = 0; i <= kMaxWrapperFields; ++i) {
+    wrapper_templates->templates[i].Dispose(isolate);
+  }
+  delete wrapper_templates;
+}
 
+// Returns template with |fields| internal fields, and one more for the type
+// tag. Templates are created on demand, once per isolate.
+static v8::Local<v8::ObjectTemplate> GetWrapperTemplate(v8::Isolate* isolate,
+                                                        int fields) {
+  IsolateData* data = IsolateData::Get(isolate);
+  WrapperTemplates* wrapper_templates = static_cast<WrapperTemplates*>(
+      data->Get(IsolateData::WRAPPER_TEMPLATES));
+  if (!wrapper_templates) {
+    wrapper_templates = new WrapperTemplates();
+    data->Set(IsolateData::WRAPPER_TEMPLATES, wrapper_templates,
+              &DeleteWrapperTemplates);
+  }
+
+  v8::Persistent<v8::ObjectTemplate>& icu_template =
+      wrapper_templates->templates[fields];
+  if (icu_template.IsEmpty()) {
+    v8::Local<v8::ObjectTemplate> raw_template(v8::ObjectTemplate::New());
+    raw_template->SetInternalFieldCount(fields + 1);
     icu_template.Reset(isolate, raw_template);
   }
 
@@ -140,21 +214,43 @@ v8::Local<v8::ObjectTemplate> Utils::GetTemplate(v8::Isolate* isolate) {
 }
 
 // static
-// Chrome Linux doesn't like static initializers in class, so we create
-// template on demand. This one has 2 internal fields.
+// Set aside internal field for ICU class.
+v8::Local<v8::ObjectTemplate> Utils::GetTemplate(v8::Isolate* isolate) {
+  return GetWrapperTemplate(isolate, 1);
+}
+
+// static
+// Set aside internal field for ICU class and additional data.
 v8::Local<v8::ObjectTemplate> Utils::GetTemplate2(v8::Isolate* isolate) {
-  static v8::Persistent<v8::ObjectTemplate> icu_template_2;
+  return GetWrapperTemplate(isolate, 2);
+}
 
-  if (icu_template_2.IsEmpty()) {
-    v8::Local<v8::ObjectTemplate> raw_template(v8::ObjectTemplate::New());
+// static
+// Set aside internal field for ICU class and four for additional data.
+v8::Local<v8::ObjectTemplate> Utils::GetTemplate5(v8::Isolate* isolate) {
+  return GetWrapperTemplate(isolate, 5);
+}
 
-    // Set aside internal field for ICU class and additional data.
-    raw_template->SetInternalFieldCount(2);
+// Type tags are small even integers, so they pass as aligned pointers and
+// never collide with real pointers other embedders keep in internal fields.
+static void* WrapperTypeToPointer(Utils::WrapperType type) {
+  return reinterpret_cast<void*>(static_cast<intptr_t>(type) << 1);
+}
 
-    icu_template_2.Reset(isolate, raw_template);
-  }
+// static
+void Utils::SetWrapperType(v8::Handle<v8::Object> obj, WrapperType type) {
+  obj->SetAlignedPointerInInternalField(obj->InternalFieldCount() - 1,
+                                        WrapperTypeToPointer(type));
+}
 
-  return v8::Local<v8::ObjectTemplate>::New(isolate, icu_template_2);
+// static
+bool Utils::HasWrapperType(v8::Handle<v8::Object> obj, WrapperType type) {
+  // Plain JavaScript objects have no internal fields, and none of ours
+  // has less than two.
+  int count = obj->InternalFieldCount();
+  return count >= 2 &&
+      obj->GetAlignedPointerFromInternalField(count - 1) ==
+          WrapperTypeToPointer(type);
 }
 
 }  // namespace v8_i18n
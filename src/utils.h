@@ -15,6 +15,9 @@
 #ifndef V8_I18N_SRC_UTILS_H_
 #define V8_I18N_SRC_UTILS_H_
 
+#include <string>
+
+#include "src/property-names.h"
 #include "unicode/uversion.h"
 #include "v8/include/v8.h"
 
@@ -26,33 +29,41 @@ namespace v8_i18n {
 
 class Utils {
  public:
+  // Kind of ICU object a JavaScript wrapper holds.
+  enum WrapperType {
+    BREAK_ITERATOR_WRAPPER = 1,
+    COLLATOR_WRAPPER,
+    DATE_FORMAT_WRAPPER,
+    NUMBER_FORMAT_WRAPPER
+  };
+
   // Safe string copy. Null terminates the destination. Copies at most
   // (length - 1) bytes.
   // We can't use snprintf since it's not supported on all relevant platforms.
   // We can't use OS::SNPrintF, it's only for internal code.
   static void StrNCopy(char* dest, int length, const char* src);
 
-  // Converts v8::String into UnicodeString. Returns false if input
-  // can't be converted into utf8.
+  // Converts v8::String into UnicodeString, copying UTF-16 code units
+  // directly. Returns false if input can't be converted into a string.
   static bool V8StringToUnicodeString(const v8::Handle<v8::Value>& input,
 				      icu::UnicodeString* output);
 
   // Extract a String setting named in |settings| and set it to |result|.
   // Return true if it's specified. Otherwise, return false.
   static bool ExtractStringSetting(const v8::Handle<v8::Object>& settings,
-                                   const char* setting,
+                                   PropertyNames::Name setting,
                                    icu::UnicodeString* result);
 
   // Extract a Integer setting named in |settings| and set it to |result|.
   // Return true if it's specified. Otherwise, return false.
   static bool ExtractIntegerSetting(const v8::Handle<v8::Object>& settings,
-                                    const char* setting,
+                                    PropertyNames::Name setting,
                                     int32_t* result);
 
   // Extract a Boolean setting named in |settings| and set it to |result|.
   // Return true if it's specified. Otherwise, return false.
   static bool ExtractBooleanSetting(const v8::Handle<v8::Object>& settings,
-                                    const char* setting,
+                                    PropertyNames::Name setting,
                                     bool* result);
 
   // Converts ASCII array into UChar array.
@@ -62,12 +73,36 @@ class Utils {
                            UChar* target,
                            int32_t target_length);
 
+  // Creates an Int32Array with |length| elements copied from |data|.
+  static v8::Local<v8::Int32Array> NewInt32Array(const int32_t* data,
+                                                 int32_t length);
+
+  // Creates an Uint8Array with |length| elements copied from |data|.
+  static v8::Local<v8::Uint8Array> NewUint8Array(const uint8_t* data,
+                                                 int32_t length);
+
+  // Returns a short cache key for binary data: its length and FNV-1a digest.
+  // Digests can collide, so callers compare the data too.
+  static std::string BinaryKey(const uint8_t* data, uint32_t length);
+
   // Creates an ObjectTemplate with one internal field.
+  // All templates reserve one more, last, internal field for the wrapper
+  // type tag.
   static v8::Local<v8::ObjectTemplate> GetTemplate(v8::Isolate* isolate);
 
   // Creates an ObjectTemplate with two internal fields.
   static v8::Local<v8::ObjectTemplate> GetTemplate2(v8::Isolate* isolate);
 
+  // Creates an ObjectTemplate with five internal fields.
+  static v8::Local<v8::ObjectTemplate> GetTemplate5(v8::Isolate* isolate);
+
+  // Tags |obj|, made from one of the templates above, with |type|.
+  static void SetWrapperType(v8::Handle<v8::Object> obj, WrapperType type);
+
+  // Returns true if |obj| was tagged with |type|. Doesn't allocate, so it's
+  // cheap enough to run at the start of every native method.
+  static bool HasWrapperType(v8::Handle<v8::Object> obj, WrapperType type);
+
  private:
   Utils() {}
 };
@@ -16,10 +16,101 @@
 // each service. The build system combines them together into one
 // Intl namespace.
 
+/**
+ * Registers installer of a service. The build wraps each service source file
+ * into an installer (see tools/js2c.py), so the service code is compiled and
+ * run only when its Intl constructor is first accessed, or when overrides
+ * need it.
+ * Known difference from ECMA-402: until then, the Intl property is a
+ * non-enumerable, configurable accessor rather than a writable data
+ * property. First access replaces it with the data property the spec
+ * requires. If Intl is frozen before that, the property stays an accessor.
+ */
+function addLazyService(service, installer) {
+  var property = LAZY_SERVICE_PROPERTIES[service];
+
+  var entry = {installer: installer, exports: undefined, getter: undefined};
+  entry.getter = function() {
+    return loadService(service).constructor;
+  };
+  lazyServices[service] = entry;
+
+  Object.defineProperty(Intl, property, {
+    get: entry.getter,
+    set: function(value) {
+      Object.defineProperty(Intl, property, {
+        value: value,
+        writable: true,
+        enumerable: false,
+        configurable: true
+      });
+    },
+    enumerable: false,
+    configurable: true
+  });
+}
+
+
+/**
+ * Installs the service if needed, and returns what it exported.
+ * If user replaced the Intl constructor before the service was installed,
+ * the replacement stays. If the installer throws, the property is restored,
+ * so the next use tries again.
+ */
+function loadService(service) {
+  var entry = lazyServices[service];
+  if (entry.exports !== undefined) {
+    return entry.exports;
+  }
+
+  var property = LAZY_SERVICE_PROPERTIES[service];
+  var descriptor = Object.getOwnPropertyDescriptor(Intl, property);
+  if (descriptor !== undefined && !descriptor.configurable) {
+    // Intl was frozen or sealed before first use, so the property stays as
+    // it is. The service is installed on a scratch object instead, and the
+    // getter returns its constructor.
+    var intl = Intl;
+    Intl = {};
+    try {
+      entry.installer();
+    } finally {
+      Intl = intl;
+    }
+    return entry.exports;
+  }
+
+  delete Intl[property];
+  try {
+    entry.installer();
+  } finally {
+    if (descriptor === undefined) {
+      delete Intl[property];
+    } else if (descriptor.get !== entry.getter ||
+               entry.exports === undefined) {
+      Object.defineProperty(Intl, property, descriptor);
+    }
+  }
+
+  return entry.exports;
+}
+
+
+/**
+ * Called by service code, once it's installed, to make its constructor and
+ * methods available to other files (e.g. overrides).
+ */
+function exportService(service, exports) {
+  lazyServices[service].exports = exports;
+}
+
+
 /**
  * Adds bound method to the prototype of the given object.
+ * If wrapperName is specified, implementation is a native method, and it's
+ * called directly with the ICU object wrapper stored under that name,
+ * instead of the Intl object.
  */
-function addBoundMethod(obj, methodName, implementation, length) {
+function addBoundMethod(obj, methodName, implementation, length, wrapperName) {
   function getter() {
     if (!this || typeof this !== 'object' ||
         this.__initializedIntlObject === undefined) {
@@ -28,7 +119,7 @@ function addBoundMethod(obj, methodName, implementation, length) {
     }
     var internalName = '__bound' + methodName + '__';
     if (this[internalName] === undefined) {
-      var that = this;
+      var that = (wrapperName === undefined) ? this : this[wrapperName];
       var boundMethod;
       if (length === undefined || length === 2) {
         boundMethod = function(x, y) {
@@ -103,19 +194,14 @@ function supportedLocalesOf(service, locales, options) {
 
   var requestedLocales = initializeLocaleList(locales);
 
-  // Cache these, they don't ever change per service.
-  if (AVAILABLE_LOCALES[service] === undefined) {
-    AVAILABLE_LOCALES[service] = getAvailableLocalesOf(service);
-  }
-
   // Use either best fit or lookup algorithm to match locales.
   if (matcher === 'best fit') {
     return initializeLocaleList(bestFitSupportedLocalesOf(
-        requestedLocales, AVAILABLE_LOCALES[service]));
+        service, requestedLocales));
   }
 
   return initializeLocaleList(lookupSupportedLocalesOf(
-      requestedLocales, AVAILABLE_LOCALES[service]));
+      service, requestedLocales));
 }
 
 
@@ -124,27 +210,9 @@ function supportedLocalesOf(service, locales, options) {
  * this service has a matching locale when using the BCP 47 Lookup algorithm.
  * Locales appear in the same order in the returned list as in the input list.
  */
-function lookupSupportedLocalesOf(requestedLocales, availableLocales) {
-  var matchedLocales = [];
-  for (var i = 0; i < requestedLocales.length; ++i) {
-    // Remove -u- extension.
-    var locale = requestedLocales[i].replace(UNICODE_EXTENSION_RE, '');
-    do {
-      if (availableLocales[locale] !== undefined) {
-        // Push requested locale not the resolved one.
-        matchedLocales.push(requestedLocales[i]);
-        break;
-      }
-      // Truncate locale if possible, if not break.
-      var pos = locale.lastIndexOf('-');
-      if (pos === -1) {
-        break;
-      }
-      locale = locale.substring(0, pos);
-    } while (true);
-  }
-
-  return matchedLocales;
+function lookupSupportedLocalesOf(service, requestedLocales) {
+  native function NativeJSLookupSupportedLocalesOf();
+  return NativeJSLookupSupportedLocalesOf(service, requestedLocales);
 }
 
 
@@ -154,9 +222,9 @@ function lookupSupportedLocalesOf(requestedLocales, availableLocales) {
  * dependent algorithm.
  * Locales appear in the same order in the returned list as in the input list.
  */
-function bestFitSupportedLocalesOf(requestedLocales, availableLocales) {
-  // TODO(cira): implement better best fit algorithm.
-  return lookupSupportedLocalesOf(requestedLocales, availableLocales);
+function bestFitSupportedLocalesOf(service, requestedLocales) {
+  native function NativeJSBestFitSupportedLocalesOf();
+  return NativeJSBestFitSupportedLocalesOf(service, requestedLocales);
 }
 
 
@@ -237,89 +305,30 @@ function resolveLocale(service, requestedLocales, options) {
  * lookup algorithm.
  */
 function lookupMatcher(service, requestedLocales) {
-  native function NativeJSGetDefaultICULocale();
+  native function NativeJSLookupMatcher();
 
   if (service.match(SERVICE_RE) === null) {
     throw new Error('Internal error, wrong service type: ' + service);
   }
 
-  // Cache these, they don't ever change per service.
-  if (AVAILABLE_LOCALES[service] === undefined) {
-    AVAILABLE_LOCALES[service] = getAvailableLocalesOf(service);
-  }
-
-  for (var i = 0; i < requestedLocales.length; ++i) {
-    // Remove all extensions.
-    var locale = requestedLocales[i].replace(ANY_EXTENSION_RE, '');
-    do {
-      if (AVAILABLE_LOCALES[service][locale] !== undefined) {
-        // Return the resolved locale and extension.
-        var extensionMatch = requestedLocales[i].match(UNICODE_EXTENSION_RE);
-        var extension = (extensionMatch === null) ? '' : extensionMatch[0];
-        return {'locale': locale, 'extension': extension, 'position': i};
-      }
-      // Truncate locale if possible.
-      var pos = locale.lastIndexOf('-');
-      if (pos === -1) {
-        break;
-      }
-      locale = locale.substring(0, pos);
-    } while (true);
-  }
-
-  // Didn't find a match, return default.
-  if (DEFAULT_ICU_LOCALE === undefined) {
-    DEFAULT_ICU_LOCALE = NativeJSGetDefaultICULocale();
-  }
-
-  return {'locale': DEFAULT_ICU_LOCALE, 'extension': '', 'position': -1};
+  // Available locales are indexed, and results memoized, natively.
+  return NativeJSLookupMatcher(service, requestedLocales);
 }
 
 
 /**
  * Returns best matched supported locale and extension info using
- * implementation dependend algorithm.
+ * implementation dependend algorithm. Locales are compared by their likely
+ * script and region, so zh-HK resolves to Traditional Chinese.
  */
 function bestFitMatcher(service, requestedLocales) {
-  // TODO(cira): implement better best fit algorithm.
-  return lookupMatcher(service, requestedLocales);
-}
-
-
-/**
- * Parses Unicode extension into key - value map.
- * Returns empty object if the extension string is invalid.
- * We are not concerned with the validity of the values at this point.
- */
-function parseExtension(extension) {
-  var extensionSplit = extension.split('-');
-
-  // Assume ['', 'u', ...] input, but don't throw.
-  if (extensionSplit.length <= 2 ||
-      (extensionSplit[0] !== '' && extensionSplit[1] !== 'u')) {
-    return {};
-  }
+  native function NativeJSBestFitMatcher();
 
-  // Key is {2}alphanum, value is {3,8}alphanum.
-  // Some keys may not have explicit values (booleans).
-  var extensionMap = {};
-  var previousKey = undefined;
-  for (var i = 2; i < extensionSplit.length; ++i) {
-    var length = extensionSplit[i].length;
-    var element = extensionSplit[i];
-    if (length === 2) {
-      extensionMap[element] = undefined;
-      previousKey = element;
-    } else if (length >= 3 && length <=8 && previousKey !== undefined) {
-      extensionMap[previousKey] = element;
-      previousKey = undefined;
-    } else {
-      // There is a value that's too long, or that doesn't have a key.
-      return {};
-    }
+  if (service.match(SERVICE_RE) === null) {
+    throw new Error('Internal error, wrong service type: ' + service);
   }
 
-  return extensionMap;
+  return NativeJSBestFitMatcher(service, requestedLocales);
 }
 
 
@@ -335,69 +344,6 @@ function toObject(value) {
 }
 
 
-/**
- * Populates internalOptions object with boolean key-value pairs
- * from extensionMap and options.
- * Returns filtered extension (number and date format constructors use
- * Unicode extensions for passing parameters to ICU).
- * It's used for extension-option pairs only, e.g. kn-normalization, but not
- * for 'sensitivity' since it doesn't have extension equivalent.
- * Extensions like nu and ca don't have options equivalent, so we place
- * undefined in the map.property to denote that.
- */
-function setOptions(inOptions, extensionMap, keyValues, getOption, outOptions) {
-  var extension = '';
-
-  function updateExtension(key, value) {
-    return '-' + key + '-' + String(value);
-  }
-
-  function updateProperty(property, type, value) {
-    if (type === 'boolean' && (typeof value === 'string')) {
-      value = (value === 'true') ? true : false;
-    }
-
-    if (property !== undefined) {
-      defineWEProperty(outOptions, property, value);
-    }
-  }
-
-  for (var key in keyValues) {
-    if (keyValues.hasOwnProperty(key)) {
-      var value = undefined;
-      var map = keyValues[key];
-      if (map.property !== undefined) {
-        // This may return true if user specifies numeric: 'false', since
-        // Boolean('nonempty') === true.
-        value = getOption(map.property, map.type, map.values);
-      }
-      if (value !== undefined) {
-        updateProperty(map.property, map.type, value);
-        extension += updateExtension(key, value);
-        continue;
-      }
-      // User options didn't have it, check Unicode extension.
-      // Here we want to convert strings 'true', 'false' into proper Boolean
-      // values (not a user error).
-      if (extensionMap.hasOwnProperty(key)) {
-        value = extensionMap[key];
-        if (value !== undefined) {
-          updateProperty(map.property, map.type, value);
-          extension += updateExtension(key, value);
-        } else if (map.type === 'boolean') {
-          // Boolean keys are allowed not to have values in Unicode extension.
-          // Those default to true.
-          updateProperty(map.property, map.type, true);
-          extension += updateExtension(key, true);
-        }
-      }
-    }
-  }
-
-  return extension === ''? '' : '-u' + extension;
-}
-
-
 /**
  * Converts all OwnProperties into
  * configurable: false, writable: false, enumerable: true.
@@ -425,49 +371,17 @@ function freezeArray(array) {
  * resolved locale. If not we return ICU result.
  */
 function getOptimalLanguageTag(original, resolved) {
-  // Returns Array<Object>, where each object has maximized and base properties.
-  // Maximized: zh -> zh-Hans-CN
-  // Base: zh-CN-u-ca-gregory -> zh-CN
-  native function NativeJSGetLanguageTagVariants();
+  // Compares maximized forms (zh -> zh-Hans-CN), and swaps base tags
+  // (zh-CN-u-ca-gregory -> zh-CN). Results are memoized natively for all
+  // services.
+  native function NativeJSGetOptimalLanguageTag();
 
   // Take care of grandfathered or simple cases.
   if (original === resolved) {
     return original;
   }
 
-  var locales = NativeJSGetLanguageTagVariants([original, resolved]);
-  if (locales[0].maximized !== locales[1].maximized) {
-    return resolved;
-  }
-
-  // Preserve extensions of resolved locale, but swap base tags with original.
-  var resolvedBase = new RegExp('^' + locales[1].base);
-  return resolved.replace(resolvedBase, locales[0].base);
-}
-
-
-/**
- * Returns an Object that contains all of supported locales for a given
- * service.
- * In addition to the supported locales we add xx-ZZ locale for each xx-Yyyy-ZZ
- * that is supported. This is required by the spec.
- */
-function getAvailableLocalesOf(service) {
-  native function NativeJSAvailableLocalesOf();
-  var available = NativeJSAvailableLocalesOf(service);
-
-  for (var i in available) {
-    if (available.hasOwnProperty(i)) {
-      var parts = i.match(/^([a-z]{2,3})-([A-Z][a-z]{3})-([A-Z]{2})$/);
-      if (parts !== null) {
-	// Build xx-ZZ. We don't care about the actual value,
-	// as long it's not undefined.
-	available[parts[1] + '-' + parts[3]] = null;
-      }
-    }
-  }
-
-  return available;
+  return NativeJSGetOptimalLanguageTag(original, resolved);
 }
 
 
@@ -513,11 +427,3 @@ function addWECPropertyIfDefined(object, property, value) {
     defineWECProperty(object, property, value);
   }
 }
-
-
-/**
- * Returns titlecased word, aMeRricA -> America.
- */
-function toTitleCaseWord(word) {
-  return word.substr(0, 1).toUpperCase() + word.substr(1).toLowerCase();
-}
@@ -0,0 +1,69 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Flags: -c 16
+
+// Adopting a text seen before is a cache hit, and gives the same boundaries
+// and types as segmenting it again.
+
+var iterator = new Intl.v8BreakIterator(['en']);
+var text = 'Jack and Jill, 12 pails.';
+
+function walk(iterator) {
+  var result = [];
+  for (var pos = iterator.first(); pos !== -1; pos = iterator.next()) {
+    result.push(pos + ':' + iterator.breakType());
+  }
+  result.push(iterator.current());
+  return result.join(',');
+}
+
+function boundaries(iterator) {
+  var result = iterator.v8Boundaries(true);
+  return Array.prototype.join.call(result.boundaries, ',') + '/' +
+      Array.prototype.join.call(result.types, ',');
+}
+
+var stats = iterator.v8CacheStats();
+var hits = stats.hits;
+var misses = stats.misses;
+
+iterator.adoptText(text);
+var first = walk(iterator);
+var firstBoundaries = boundaries(iterator);
+assertEquals(misses + 1, iterator.v8CacheStats().misses);
+
+iterator.adoptText('something else');
+assertEquals(misses + 2, iterator.v8CacheStats().misses);
+
+iterator.adoptText(text);
+assertEquals(hits + 1, iterator.v8CacheStats().hits);
+assertEquals(misses + 2, iterator.v8CacheStats().misses);
+assertEquals(first, walk(iterator));
+assertEquals(firstBoundaries, boundaries(iterator));
+
+// Iterators of the same locale and type share the cache.
+var other = new Intl.v8BreakIterator(['en']);
+other.adoptText(text);
+assertEquals(hits + 2, other.v8CacheStats().hits);
+assertEquals(first, walk(other));
+assertEquals(firstBoundaries, boundaries(other));
+
+// Texts too long to cache are neither hits nor misses.
+var long = new Array(1100).join('a ');
+other.adoptText(long);
+other.adoptText(long);
+stats = other.v8CacheStats();
+assertEquals(hits + 2, stats.hits);
+assertEquals(misses + 2, stats.misses);
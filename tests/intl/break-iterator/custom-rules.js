@@ -0,0 +1,94 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Custom rules keep hashtags together, and survive a round trip through
+// their compiled form. Compiled rules that weren't handed out by
+// v8BinaryRules(), or registered by the embedder, are rejected.
+
+var rules = '$Letter = [a-zA-Z0-9_];' +
+            '\\#$Letter+ {200};' +
+            '$Letter+ {200};';
+
+function walk(iterator) {
+  var result = [];
+  for (var pos = iterator.first(); pos !== -1; pos = iterator.next()) {
+    result.push(pos + ':' + iterator.breakType());
+  }
+  return result.join(',');
+}
+
+var iterator = new Intl.v8BreakIterator(['en'], {v8Rules: rules});
+iterator.adoptText('#v8 and #icu');
+var expected = '0:none,3:letter,4:none,7:letter,8:none,12:letter';
+assertEquals(expected, walk(iterator));
+
+var binary = iterator.v8BinaryRules();
+assertTrue(binary instanceof Uint8Array);
+assertTrue(binary.length > 0);
+
+var loaded = new Intl.v8BreakIterator(['en'], {v8BinaryRules: binary});
+loaded.adoptText('#v8 and #icu');
+assertEquals(expected, walk(loaded));
+
+// ArrayBuffer works too.
+loaded = new Intl.v8BreakIterator(['en'], {v8BinaryRules: binary.buffer});
+loaded.adoptText('#v8 and #icu');
+assertEquals(expected, walk(loaded));
+
+assertThrows(function() {
+  new Intl.v8BreakIterator(['en'], {v8BinaryRules: 'not binary'});
+});
+assertThrows(function() {
+  new Intl.v8BreakIterator(['en'], {v8BinaryRules: new Uint8Array(256)});
+});
+
+var tampered = new Uint8Array(binary);
+tampered[tampered.length - 1] ^= 1;
+assertThrows(function() {
+  new Intl.v8BreakIterator(['en'], {v8BinaryRules: tampered});
+});
+
+// Many distinct rules push old ones out of the cache. Iterators keep
+// working, and asking for their compiled rules again renews them.
+for (var i = 0; i < 40; ++i) {
+  var churn = new Intl.v8BreakIterator(['en'], {
+    v8Rules: '$Letter = [a-zA-Z0-9_];$Letter+ {' + (300 + i) + '};'
+  });
+  churn.v8BinaryRules();
+}
+assertEquals(expected, walk(iterator));
+assertEquals(expected, walk(loaded));
+assertThrows(function() {
+  new Intl.v8BreakIterator(['en'], {v8BinaryRules: binary});
+});
+
+binary = iterator.v8BinaryRules();
+loaded = new Intl.v8BreakIterator(['en'], {v8BinaryRules: binary});
+loaded.adoptText('#v8 and #icu');
+assertEquals(expected, walk(loaded));
+
+// Rules that don't compile say where.
+assertThrows(function() {
+  new Intl.v8BreakIterator(['en'], {v8Rules: '$Letter = [a-z'});
+}, SyntaxError);
+var error;
+try {
+  new Intl.v8BreakIterator(['en'], {
+    v8Rules: '$Letter = [a-z];\n$Letter+ {200};\n$Missing+;'
+  });
+} catch (e) {
+  error = e;
+}
+assertInstanceof(error, SyntaxError);
+assertEquals('Invalid v8Rules at line 3, offset 9.', error.message);
@@ -0,0 +1,55 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Bulk boundaries have to match the ones we get by calling next().
+
+var iterator = new Intl.v8BreakIterator(['en']);
+
+var textToSegment = 'Jack and Jill, went over hill, and got 42 lost. Alert!';
+iterator.adoptText(textToSegment);
+
+var positions = [];
+var types = [];
+var pos = iterator.first();
+while (pos !== -1) {
+  positions.push(pos);
+  types.push(iterator.breakType());
+  pos = iterator.next();
+}
+
+iterator.first();
+iterator.next();
+
+var boundaries = iterator.v8Boundaries();
+assertTrue(boundaries instanceof Int32Array);
+assertEquals(positions.length, boundaries.length);
+for (var i = 0; i < positions.length; ++i) {
+  assertEquals(positions[i], boundaries[i]);
+}
+
+// Iterator position is preserved.
+assertEquals(positions[1], iterator.current());
+
+var result = iterator.v8Boundaries(true);
+assertTrue(result.types instanceof Uint8Array);
+assertEquals(positions.length, result.boundaries.length);
+assertEquals(positions.length, result.types.length);
+for (var i = 0; i < positions.length; ++i) {
+  assertEquals(positions[i], result.boundaries[i]);
+  assertEquals(types[i], Intl.v8BreakIterator.v8BreakTypes[result.types[i]]);
+}
+
+// Empty text still has one boundary.
+iterator.adoptText('');
+assertEquals(1, iterator.v8Boundaries().length);
@@ -0,0 +1,38 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tokenize plain English sentence in one call and check results.
+
+var iterator = new Intl.v8BreakIterator(['en']);
+
+// Nothing adopted yet.
+assertEquals(0, iterator.v8Tokens().tokens.length);
+
+iterator.adoptText('Jack and Jill, went over 2 hills.');
+
+var result = iterator.v8Tokens();
+var expected = ['Jack', 'and', 'Jill', 'went', 'over', '2', 'hills'];
+assertEquals(expected.length, result.tokens.length);
+assertEquals(expected.length, result.types.length);
+for (var i = 0; i < expected.length; ++i) {
+  assertEquals(expected[i], result.tokens[i]);
+}
+assertEquals('letter', result.types[0]);
+assertEquals('number', result.types[5]);
+
+// With none segments, tokens cover the whole text.
+result = iterator.v8Tokens(true);
+assertEquals('Jack and Jill, went over 2 hills.', result.tokens.join(''));
+assertEquals(' ', result.tokens[1]);
+assertEquals('none', result.types[1]);
@@ -0,0 +1,43 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Count and truncate user perceived characters, and make sure the Latin-1
+// fast path agrees with ICU.
+
+var iterator = new Intl.v8BreakIterator(['en'], {type: 'character'});
+
+// e + combining acute accent, CR LF, Hangul syllable in jamo, surrogate pair.
+var text = 'Cafe\u0301 caf\u00E9\r\n\u1100\u1161\u11A8 \uD83D\uDE00 end';
+iterator.adoptText(text);
+
+var boundaries = iterator.v8Boundaries();
+assertEquals(boundaries.length - 1, iterator.v8SegmentCount());
+
+for (var i = 0; i < boundaries.length; ++i) {
+  assertEquals(boundaries[i], iterator.v8SegmentOffset(i));
+}
+assertEquals(text.length, iterator.v8SegmentOffset(1000));
+assertEquals(0, iterator.v8SegmentOffset(-1));
+
+// Pure ASCII.
+iterator.adoptText('Hello world');
+assertEquals(11, iterator.v8SegmentCount());
+assertEquals(5, iterator.v8SegmentOffset(5));
+
+// Truncate without cutting a word.
+var words = new Intl.v8BreakIterator(['en']);
+words.adoptText('Jack and Jill');
+assertEquals(8, words.v8PrecedingBoundary(10));
+assertEquals(4, words.v8PrecedingBoundary(4));
+assertEquals(13, words.v8PrecedingBoundary(100));
@@ -0,0 +1,48 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Wrap text to a fixed width at line break opportunities.
+
+var iterator = new Intl.v8BreakIterator(['en'], {type: 'line'});
+
+iterator.adoptText('Jack and Jill went up the hill');
+var breaks = iterator.v8Wrap(10);
+assertTrue(breaks instanceof Int32Array);
+// 'Jack and ' | 'Jill went ' | 'up the ' | 'hill'
+assertEquals(3, breaks.length);
+assertEquals(9, breaks[0]);
+assertEquals(19, breaks[1]);
+assertEquals(26, breaks[2]);
+
+// Mandatory breaks always start a new line.
+iterator.adoptText('a b\nc d');
+breaks = iterator.v8Wrap(80);
+assertEquals(1, breaks.length);
+assertEquals(4, breaks[0]);
+
+// Words longer than the line overflow it.
+iterator.adoptText('abcdefghij xy');
+breaks = iterator.v8Wrap(4);
+assertEquals(1, breaks.length);
+assertEquals(11, breaks[0]);
+
+// Ideographs take two columns each.
+iterator.adoptText('\u56FD\u52A1\u9662\u5173\u4E8E');
+assertEquals(0, iterator.v8Wrap(5).length);
+breaks = iterator.v8Wrap(5, true);
+assertEquals(2, breaks.length);
+assertEquals(2, breaks[0]);
+assertEquals(4, breaks[1]);
+
+assertThrows('iterator.v8Wrap(0)');
@@ -0,0 +1,36 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Parallel segmentation of a long text has to give the same results as
+// sequential one.
+
+var paragraph = '\u56FD\u52A1\u9662\u5173\u4E8E\u300A\u571F\u5730' +
+                '\u623F\u5C4B\u7BA1\u7406\u6761\u4F8B\u300B' +
+                ' Jack and Jill, went over 2 hills.';
+var text = '';
+for (var i = 0; i < 3000; ++i) {
+  text += paragraph + (i % 2 ? '\n' : '\r\n');
+}
+
+var iterator = new Intl.v8BreakIterator(['zh']);
+iterator.adoptText(text);
+
+var expected = iterator.v8Boundaries(true);
+var actual = iterator.v8Boundaries(true, 4);
+
+assertEquals(expected.boundaries.length, actual.boundaries.length);
+for (var i = 0; i < expected.boundaries.length; ++i) {
+  assertEquals(expected.boundaries[i], actual.boundaries[i]);
+  assertEquals(expected.types[i], actual.types[i]);
+}
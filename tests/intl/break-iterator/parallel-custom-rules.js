@@ -0,0 +1,41 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Custom rules may not break at line separators, so an iterator created from
+// them has to give the same results with any number of threads.
+
+// Words run across newlines and end only at spaces.
+var rules = '$NotSpace = [^\\u0020];' +
+            '$NotSpace+ {200};';
+
+var text = '';
+for (var i = 0; i < 10000; ++i) {
+  text += 'abc\ndef ';
+}
+
+var iterator = new Intl.v8BreakIterator(['en'], {v8Rules: rules});
+iterator.adoptText(text);
+
+var expected = iterator.v8Boundaries(true);
+var actual = iterator.v8Boundaries(true, 4);
+
+assertEquals(2 * 10000 + 1, expected.boundaries.length);
+assertEquals(7, expected.boundaries[1]);
+assertEquals(8, expected.boundaries[2]);
+
+assertEquals(expected.boundaries.length, actual.boundaries.length);
+for (var i = 0; i < expected.boundaries.length; ++i) {
+  assertEquals(expected.boundaries[i], actual.boundaries[i]);
+  assertEquals(expected.types[i], actual.types[i]);
+}
@@ -0,0 +1,53 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Flags: -b word-rules.brk
+
+// Compiled rules the embedder registered load in any isolate, without
+// being exported by v8BinaryRules() first. The fixture holds the rules
+//   $Letter = [a-zA-Z0-9_];$Letter+ {200};
+// compiled by ICU 72. Compiled rules only load in the ICU version that
+// compiled them, so the fixture has to be regenerated, from v8BinaryRules()
+// of an iterator with these rules, when ICU is updated.
+
+function walk(iterator) {
+  var result = [];
+  for (var pos = iterator.first(); pos !== -1; pos = iterator.next()) {
+    result.push(pos + ':' + iterator.breakType());
+  }
+  return result.join(',');
+}
+
+var expected = '0:none,2:letter,3:none,5:letter';
+
+var iterator = new Intl.v8BreakIterator(['en'],
+                                        {v8BinaryRules: registeredBreakRules});
+iterator.adoptText('ab cd');
+assertEquals(expected, walk(iterator));
+
+// A copy of the same bytes works too, and so does the exported form.
+var copy = new Uint8Array(registeredBreakRules);
+iterator = new Intl.v8BreakIterator(['en'], {v8BinaryRules: copy.buffer});
+iterator.adoptText('ab cd');
+assertEquals(expected, walk(iterator));
+
+var exported = iterator.v8BinaryRules();
+assertEquals(registeredBreakRules.length, exported.length);
+assertEquals(Array.prototype.join.call(registeredBreakRules),
+             Array.prototype.join.call(exported));
+
+copy[copy.length - 1] ^= 1;
+assertThrows(function() {
+  new Intl.v8BreakIterator(['en'], {v8BinaryRules: copy});
+}, TypeError);
@@ -0,0 +1,66 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Chunked segmentation of streams that can't be settled at line breaks has
+// to produce the same boundaries as segmenting the whole text at once.
+
+function segmentInChunks(iterator, text, chunkSize) {
+  var actual = [];
+  for (var start = 0; start < text.length; start += chunkSize) {
+    var chunk = text.substring(start, start + chunkSize);
+    var isLast = start + chunkSize >= text.length;
+    var result = iterator.v8SegmentChunk(chunk, isLast);
+    for (var i = 0; i < result.length; ++i) {
+      actual.push(result[i]);
+    }
+  }
+  return actual;
+}
+
+function assertSameAsWhole(iterator, text) {
+  iterator.adoptText(text);
+  var expected = iterator.v8Boundaries();
+
+  [1000, 4096, 30000, text.length].forEach(function(chunkSize) {
+    var actual = segmentInChunks(iterator, text, chunkSize);
+    assertEquals(expected.length, actual.length);
+    for (var i = 0; i < expected.length; ++i) {
+      assertEquals(expected[i], actual[i]);
+    }
+  });
+}
+
+// Words run across newlines and end only at spaces, so custom rules don't
+// break after line separators.
+var rules = '$NotSpace = [^\\u0020];' +
+            '$NotSpace+ {200};';
+var text = '';
+for (var i = 0; i < 10000; ++i) {
+  text += 'abc\ndef ';
+}
+assertSameAsWhole(new Intl.v8BreakIterator(['en'], {v8Rules: rules}), text);
+
+// Thai words come from a dictionary, and a line of them is longer than the
+// stream keeps.
+var sentence = '\u0E20\u0E32\u0E29\u0E32\u0E44\u0E17\u0E22\u0E40' +
+               '\u0E1B\u0E47\u0E19\u0E20\u0E32\u0E29\u0E32\u0E17\u0E35' +
+               '\u0E48\u0E21\u0E35\u0E04\u0E27\u0E32\u0E21\u0E0B\u0E31' +
+               '\u0E1A\u0E0B\u0E49\u0E2D\u0E19\u0E41\u0E25\u0E30\u0E21' +
+               '\u0E35\u0E27\u0E23\u0E23\u0E13\u0E22\u0E38\u0E01\u0E15' +
+               '\u0E4C';
+text = '';
+for (var i = 0; i < 3000; ++i) {
+  text += sentence;
+}
+assertSameAsWhole(new Intl.v8BreakIterator(['th'], {type: 'word'}), text);
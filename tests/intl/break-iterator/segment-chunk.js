@@ -0,0 +1,61 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Chunked segmentation has to produce the same boundaries as segmenting
+// the whole text at once, no matter where the chunks are split.
+
+var text = 'Jack and Jill, went over hill.\nAnd got lost.\r\n' +
+           '\u56FD\u52A1\u9662\u5173\u4E8E\u300A\u571F\u5730\n' +
+           'Alert! The end.';
+
+['word', 'line', 'sentence', 'character'].forEach(function(type) {
+  var iterator = new Intl.v8BreakIterator(['zh'], {type: type});
+  iterator.adoptText(text);
+  var expected = iterator.v8Boundaries();
+
+  [1, 3, 7, 16, text.length].forEach(function(chunkSize) {
+    var actual = [];
+    for (var start = 0; start < text.length; start += chunkSize) {
+      var chunk = text.substring(start, start + chunkSize);
+      var isLast = start + chunkSize >= text.length;
+      var result = iterator.v8SegmentChunk(chunk, isLast);
+      for (var i = 0; i < result.length; ++i) {
+        actual.push(result[i]);
+      }
+    }
+
+    assertEquals(expected.length, actual.length);
+    for (var i = 0; i < expected.length; ++i) {
+      assertEquals(expected[i], actual[i]);
+    }
+  });
+});
+
+// Streaming leaves the adopted text and the position alone.
+var iterator = new Intl.v8BreakIterator(['en'], {type: 'word'});
+iterator.adoptText('Hello world.');
+iterator.first();
+assertEquals(5, iterator.next());
+iterator.v8SegmentChunk('Something else entirely', false);
+assertEquals(5, iterator.current());
+assertEquals(6, iterator.next());
+assertEquals(11, iterator.next());
+assertEquals(12, iterator.next());
+
+// Adopting text in the middle of a stream starts a new one.
+iterator.v8SegmentChunk('Discarded', false);
+iterator.adoptText('Hello world.');
+var result = iterator.v8SegmentChunk('Hi there', true);
+assertEquals(0, result[0]);
+assertEquals(8, result[result.length - 1]);
@@ -0,0 +1,73 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Custom tailoring puts z before a, and survives a round trip through the
+// binary image.
+
+var strings = ['apple', 'zebra', 'mango'];
+
+var collator = Intl.Collator(['en'], {v8Rules: '&[before 1]a < z'});
+assertEquals('zebra,apple,mango', strings.slice().sort(collator.compare).join());
+
+// Options still apply on top of the tailoring.
+collator = Intl.Collator(['en'], {v8Rules: '&[before 1]a < z',
+                                  sensitivity: 'base'});
+assertEquals(0, collator.compare('Zebra', 'zebra'));
+
+var binary = collator.v8BinaryRules();
+assertTrue(binary instanceof Uint8Array);
+assertTrue(binary.length > 0);
+
+var loaded = Intl.Collator(['en'], {v8BinaryRules: binary});
+assertEquals('zebra,apple,mango', strings.slice().sort(loaded.compare).join());
+
+loaded = Intl.Collator(['en'], {v8BinaryRules: binary.buffer});
+assertEquals('zebra,apple,mango', strings.slice().sort(loaded.compare).join());
+
+// Untailored collator is not affected.
+assertEquals('apple,mango,zebra',
+             strings.slice().sort(Intl.Collator(['en']).compare).join());
+
+assertThrows(function() {
+  Intl.Collator(['en'], {v8BinaryRules: 'not binary'});
+});
+assertThrows(function() {
+  Intl.Collator(['en'], {v8Rules: '&a <'});
+});
+
+// Images are never loaded, only matched against the ones v8BinaryRules()
+// returned.
+var tampered = new Uint8Array(binary);
+tampered[tampered.length - 1] ^= 1;
+assertThrows(function() {
+  Intl.Collator(['en'], {v8BinaryRules: tampered});
+});
+
+// Compiled collators are bounded. Collators outlive their evicted rules,
+// and evicted images are renewed by asking for them again.
+var collators = [];
+for (var i = 0; i < 40; i++) {
+  collators.push(Intl.Collator(['en'], {v8Rules: '&[before 1]a < z' + i}));
+  collators[i].v8BinaryRules();
+}
+for (var i = 0; i < collators.length; i++) {
+  assertEquals(-1, collators[i].compare('z' + i, 'apple'));
+}
+
+assertThrows(function() {
+  Intl.Collator(['en'], {v8BinaryRules: binary});
+});
+binary = collator.v8BinaryRules();
+loaded = Intl.Collator(['en'], {v8BinaryRules: binary});
+assertEquals('zebra,apple,mango', strings.slice().sort(loaded.compare).join());
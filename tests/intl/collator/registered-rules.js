@@ -0,0 +1,41 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Flags: -o z-before-a.col
+
+// Binary images the embedder registered load in any isolate, without being
+// exported by v8BinaryRules() first. The fixture holds the tailoring
+//   &[before 1]a < z
+// compiled by ICU 72. Images only load in the ICU version that compiled
+// them, so the fixture has to be regenerated, from v8BinaryRules() of a
+// collator with this tailoring, when ICU is updated.
+
+function sorted(collator) {
+  return ['apple', 'zebra', 'mango'].sort(collator.compare).join();
+}
+
+var collator = Intl.Collator(['en'], {v8BinaryRules: registeredCollatorRules});
+assertEquals('zebra,apple,mango', sorted(collator));
+
+// A copy of the same bytes works too, and options apply on top.
+var copy = new Uint8Array(registeredCollatorRules);
+collator = Intl.Collator(['en'], {v8BinaryRules: copy.buffer,
+                                  sensitivity: 'base'});
+assertEquals('zebra,apple,mango', sorted(collator));
+assertEquals(0, collator.compare('Zebra', 'zebra'));
+
+copy[copy.length - 1] ^= 1;
+assertThrows(function() {
+  Intl.Collator(['en'], {v8BinaryRules: copy});
+}, TypeError);
@@ -0,0 +1,41 @@
+// Copyright 2012 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests Intl.v8MatchAcceptLanguage.
+
+var header = 'da, en-gb;q=0.8, en;q=0.7';
+assertEquals('da', Intl.v8MatchAcceptLanguage(header, 'collator'));
+// Cached result is the same.
+assertEquals('da', Intl.v8MatchAcceptLanguage(header, 'collator'));
+
+// Quality decides, not the order.
+assertEquals('de', Intl.v8MatchAcceptLanguage(
+    'xx;q=0.9, fr;q=0.5, de', 'numberformat').substr(0, 2));
+
+// Zero quality, wildcards and invalid tags are skipped.
+assertEquals('sr', Intl.v8MatchAcceptLanguage(
+    'de;q=0, *, en_US, !!, sr;q=0.1', 'dateformat').substr(0, 2));
+
+// Nothing usable gives the default locale.
+var defaultLocale = Intl.DateTimeFormat().resolvedOptions().locale;
+assertEquals(defaultLocale, Intl.v8MatchAcceptLanguage('', 'dateformat'));
+assertEquals(defaultLocale, Intl.v8MatchAcceptLanguage('xx, *;q=0.5',
+                                                       'dateformat'));
+
+// Result can be used to construct the service.
+var nf = Intl.NumberFormat(Intl.v8MatchAcceptLanguage('en-US,en;q=0.9',
+                                                      'numberformat'));
+assertEquals('en', nf.resolvedOptions().locale.substr(0, 2));
+
+assertThrows('Intl.v8MatchAcceptLanguage("en", "calendar")');
@@ -0,0 +1,37 @@
+// Copyright 2012 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Best fit picks a locale in the same script, and a close region.
+
+for (var i = 0; i < 2; ++i) {
+  // Lookup would truncate zh-HK to zh, which is Simplified Chinese.
+  var nf = Intl.NumberFormat(['zh-HK', 'en']);
+  var locale = nf.resolvedOptions().locale;
+  assertEquals('zh', locale.substr(0, 2));
+  assertTrue(locale !== 'zh' && locale.indexOf('Hans') === -1 &&
+             locale !== 'zh-CN');
+
+  var lookup = Intl.NumberFormat(['zh-HK', 'en'], {localeMatcher: 'lookup'});
+  assertEquals('zh', lookup.resolvedOptions().locale.substr(0, 2));
+}
+
+// Extension is kept.
+var dtf = Intl.DateTimeFormat(['sr-ME-u-ca-gregory']);
+assertEquals('sr', dtf.resolvedOptions().locale.substr(0, 2));
+assertEquals('gregory', dtf.resolvedOptions().calendar);
+
+var supported = Intl.NumberFormat.supportedLocalesOf(['xx', 'en-AU', 'zh-HK']);
+assertEquals(2, supported.length);
+assertEquals('en-AU', supported[0]);
+assertEquals('zh-HK', supported[1]);
@@ -0,0 +1,42 @@
+// Copyright 2012 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Flags: -d 3 -c 16
+
+// The runner disposes of the extension's data after each run, while these
+// objects are still alive, and collects them afterwards. Break iterator
+// pools, cached segmentations and compiled collators they use must outlive
+// the data.
+
+var strings = ['apple', 'zebra', 'mango'];
+
+var collator = Intl.Collator(['en'], {v8Rules: '&[before 1]a < z'});
+var loaded = Intl.Collator(['en'], {v8BinaryRules: collator.v8BinaryRules()});
+assertEquals('zebra,apple,mango', strings.slice().sort(loaded.compare).join());
+
+var iterator = new Intl.v8BreakIterator(['en']);
+iterator.adoptText('Hello world.');
+assertEquals(5, iterator.next());
+
+var cached = new Intl.v8BreakIterator(['en']);
+cached.adoptText('Hello world.');
+assertEquals(5, cached.next());
+
+var custom = new Intl.v8BreakIterator(['en'], {
+  v8Rules: '$Letter = [a-zA-Z0-9_];$Letter+ {200};'
+});
+var copy = new Intl.v8BreakIterator(['en'],
+                                    {v8BinaryRules: custom.v8BinaryRules()});
+copy.adoptText('ab cd');
+assertEquals(2, copy.next());
@@ -0,0 +1,41 @@
+// Copyright 2012 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Services are installed on first use. Freezing Intl before that must not
+// break them, nor the built-in methods they override.
+
+Object.freeze(Intl);
+
+assertEquals(-1, 'a'.localeCompare('b'));
+assertEquals('1,234', (1234).toLocaleString('en'));
+
+var collator = new Intl.Collator(['en']);
+assertEquals(-1, collator.compare('a', 'b'));
+assertEquals(Intl.Collator, Intl.Collator);
+assertTrue(collator instanceof Intl.Collator);
+
+// Called as a function.
+assertEquals('en', Intl.Collator(['en']).resolvedOptions().locale);
+assertEquals(1, Intl.Collator.supportedLocalesOf(['en']).length);
+
+var iterator = new Intl.v8BreakIterator(['en']);
+iterator.adoptText('a b');
+assertEquals(1, iterator.next());
+
+assertTrue(Object.isFrozen(Intl));
+
+// Properties frozen before first use stay accessors.
+var descriptor = Object.getOwnPropertyDescriptor(Intl, 'Collator');
+assertEquals('function', typeof descriptor.get);
+assertEquals(Intl.Collator, descriptor.get.call(Intl));
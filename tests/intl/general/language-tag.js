@@ -0,0 +1,37 @@
+// Copyright 2012 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests validation and canonicalization of language tags.
+
+var valid = ['en', 'EN-us', 'zh-Hant-TW', 'sr-Latn-RS', 'de-CH-1996',
+             'sl-rozaj-biske', 'es-419', 'zh-cmn-Hans-CN', 'en-US-x-twain',
+             'x-private', 'i-klingon', 'zh-min-nan', 'de-u-co-phonebk',
+             'en-a-bbb-b-ccc', 'qaa-Qaaa-QM-x-southern'];
+for (var i = 0; i < valid.length; ++i) {
+  // Throws if the tag is rejected.
+  Intl.Collator.supportedLocalesOf(valid[i]);
+}
+
+assertEquals('en-US', Intl.NumberFormat.supportedLocalesOf('EN-us')[0]);
+
+var invalid = ['', 'e', 'en-', '-en', 'en--US', 'abcdefghi', 'en-US-',
+               'de-1996-1996', 'en-a-bbb-a-ccc', 'en-a', 'en-x', 'x',
+               'hant-cmn-cn', 'en-\u00E9', 'en_US', 'en-u-toolongvalue'];
+for (var i = 0; i < invalid.length; ++i) {
+  assertThrows('Intl.Collator.supportedLocalesOf(' +
+               JSON.stringify(invalid[i]) + ')');
+  // Second time comes from the cache.
+  assertThrows('Intl.Collator.supportedLocalesOf(' +
+               JSON.stringify(invalid[i]) + ')');
+}
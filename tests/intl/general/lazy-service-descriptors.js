@@ -0,0 +1,35 @@
+// Copyright 2012 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Intl constructors are accessors until first use (a known difference from
+// ECMA-402), and become writable, non-enumerable, configurable data
+// properties once used.
+
+['Collator', 'NumberFormat', 'DateTimeFormat', 'v8BreakIterator'].forEach(
+    function(property) {
+  var before = Object.getOwnPropertyDescriptor(Intl, property);
+  assertEquals('function', typeof before.get);
+  assertFalse(before.enumerable);
+  assertTrue(before.configurable);
+
+  var constructor = Intl[property];
+  assertEquals('function', typeof constructor);
+
+  var after = Object.getOwnPropertyDescriptor(Intl, property);
+  assertEquals(constructor, after.value);
+  assertEquals(undefined, after.get);
+  assertTrue(after.writable);
+  assertFalse(after.enumerable);
+  assertTrue(after.configurable);
+});
@@ -0,0 +1,39 @@
+// Copyright 2012 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Lookup drops extensions for matching, keeps -u- for the service, and
+// gives the same answer when the same list is requested again.
+
+var options = {localeMatcher: 'lookup'};
+
+for (var i = 0; i < 2; ++i) {
+  var collator = Intl.Collator(['xx-YY', 'de-CH-u-co-phonebk'], options);
+  assertEquals('de', collator.resolvedOptions().locale.substr(0, 2));
+  assertEquals('phonebk', collator.resolvedOptions().collation);
+
+  var nf = Intl.NumberFormat(['sr-Latn-RS-x-private', 'en'], options);
+  assertEquals('sr', nf.resolvedOptions().locale.substr(0, 2));
+  assertEquals(-1, nf.resolvedOptions().locale.indexOf('private'));
+}
+
+var supported = Intl.NumberFormat.supportedLocalesOf(
+    ['xx', 'de-AT-u-nu-latn', 'zh-TW', 'yy-ZZ'], options);
+assertEquals(2, supported.length);
+assertEquals('de-AT-u-nu-latn', supported[0]);
+assertEquals('zh-TW', supported[1]);
+
+// Nothing matches, so default locale is used.
+var dtf = Intl.DateTimeFormat(['xx'], options);
+assertEquals(Intl.DateTimeFormat().resolvedOptions().locale,
+             dtf.resolvedOptions().locale);
@@ -12,8 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// Performance test for overriden methods. Makes sure that default case
-// is faster (cached) than the general case.
+// Performance test for overriden methods. Makes sure that default case,
+// and repeated calls with the same arguments, are faster (cached) than the
+// general case.
 
 // Default, cached.
 var startTime = new Date();
@@ -23,10 +24,19 @@ for (var i = 0; i < 1000; i++) {
 var endTime = new Date();
 var cachedTime = endTime.getTime() - startTime.getTime();
 
-// Not cached.
+// Same explicit arguments, cached after the first call.
 startTime = new Date();
 for (var i = 0; i < 1000; i++) {
-  'a'.localeCompare('c', 'sr');
+  'a'.localeCompare('c', 'sr', {sensitivity: 'base'});
+}
+endTime = new Date();
+var keyedTime = endTime.getTime() - startTime.getTime();
+
+// Not cached, options with accessors are never cached.
+var options = {get sensitivity() { return 'base'; }};
+startTime = new Date();
+for (var i = 0; i < 1000; i++) {
+  'a'.localeCompare('c', 'sr', options);
 }
 endTime = new Date();
 var nonCachedTime = endTime.getTime() - startTime.getTime();
@@ -44,4 +54,5 @@ collatorTime = endTime.getTime() - startTime.getTime();
 assertTrue(collatorTime < cachedTime);
 // Non-cached time is much slower, measured to 12.5 times.
 assertTrue(cachedTime < nonCachedTime);
+assertTrue(keyedTime < nonCachedTime);
 
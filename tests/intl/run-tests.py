@@ -36,9 +36,35 @@ def ListTests(start_dir):
   return tests
 
 
+# Test runner flags that take a file name.
+FILE_FLAGS = ['-b', '-o']
+
+
+def ReadFlags(test):
+  '''
+  Returns test-runner flags a test asks for with a "// Flags:" line.
+  Fixture files are named relative to the test.
+  '''
+  for line in open(test):
+    if line.startswith('// Flags:'):
+      flags = line[len('// Flags:'):].split()
+      for i in range(1, len(flags)):
+        if flags[i - 1] in FILE_FLAGS:
+          flags[i] = os.path.join(os.path.dirname(test), flags[i])
+      return flags
+  return []
+
+
 def main(argv):
+  # With -j, each test runs concurrently in that many isolates, one per
+  # thread, to stress per isolate state of the extension.
+  threads = []
+  if (len(argv) == 4 and argv[1] == '-j'):
+    threads = ['-j', argv[2]]
+    argv = [argv[0], argv[3]]
+
   if (len(argv) != 2):
-    print 'Usage:\n\tpython run-tests.py path/to/test-runner'
+    print 'Usage:\n\tpython run-tests.py [-j threads] path/to/test-runner'
     return
 
   script_dir = os.path.normpath(os.path.dirname(__file__))
@@ -54,7 +80,11 @@ def main(argv):
   print
   for test in tests:
     print 'Testing: ', test
-    status = subprocess.call([argv[1], asserter, utils, date, test])
+    # Tests that pick their own run mode keep it.
+    flags = ReadFlags(test)
+    mode = [] if '-d' in flags or '-t' in flags else threads
+    command = [argv[1]] + mode + flags + [asserter, utils, date, test]
+    status = subprocess.call(command)
     if status == 0:
       passed.append(test)
       print 'PASS'
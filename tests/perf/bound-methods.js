@@ -0,0 +1,23 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the performance of binding methods to fresh instances and calling
+// them once. We monitor bound method creation and the call path.
+
+var values = ['b', 'a', 'c'];
+for (var i = 0; i < 100; ++i) {
+  values.sort(new Intl.Collator('en').compare);
+  new Intl.NumberFormat('en').format(i);
+  new Intl.DateTimeFormat('en').format(i);
+}
@@ -0,0 +1,29 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the performance of constructing services with explicit options.
+// We monitor native option extraction and resolved settings.
+
+for (var i = 0; i < 100; ++i) {
+  var nf = new Intl.NumberFormat(
+      'en', {style: 'currency', currency: 'EUR', minimumFractionDigits: 1,
+             maximumFractionDigits: 3, useGrouping: false});
+  var df = new Intl.DateTimeFormat(
+      'en', {timeZone: 'UTC', year: 'numeric', month: 'long'});
+  var coll = new Intl.Collator(
+      'en', {sensitivity: 'accent', numeric: true, ignorePunctuation: true});
+  nf.resolvedOptions();
+  df.resolvedOptions();
+  coll.resolvedOptions();
+}
@@ -0,0 +1,33 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the per-call overhead of cheap native methods.
+// We monitor unpacking of the ICU object from its wrapper.
+
+var collator = new Intl.Collator('en');
+var numberFormat = new Intl.NumberFormat('en');
+var dateFormat = new Intl.DateTimeFormat('en');
+var iterator = new Intl.v8BreakIterator('en');
+var date = new Date(0);
+
+iterator.adoptText('a b c d e f g h i j');
+
+for (var i = 0; i < 100; ++i) {
+  collator.compare('a', 'b');
+  numberFormat.format(i);
+  dateFormat.format(date);
+  if (iterator.next() === -1) {
+    iterator.first();
+  }
+}
@@ -0,0 +1,26 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the performance of overriden methods called with explicit locales
+// and options. We monitor the keyed cache of service instances.
+
+var date = new Date(0);
+for (var i = 0; i < 100; ++i) {
+  'a'.localeCompare('b', 'de');
+  'a'.localeCompare('b', ['de', 'en'], {sensitivity: 'base'});
+  (1234.5).toLocaleString('en', {style: 'currency', currency: 'EUR'});
+  date.toLocaleDateString('fr');
+  date.toLocaleTimeString('fr', {hour12: false});
+  date.toLocaleString('ja', {timeZone: 'UTC'});
+}
@@ -0,0 +1,22 @@
+// Copyright 2013 the v8-i18n authors.
+//
+// Licensed under the Apache License, Version 2.0 (the 'License');
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an 'AS IS' BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the performance of context creation followed by first use of each
+// service. Compare with empty.js, which creates the context only.
+// We monitor lazy installation of the services.
+
+new Intl.Collator();
+new Intl.NumberFormat();
+new Intl.DateTimeFormat();
+new Intl.v8BreakIterator();
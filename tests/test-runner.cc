@@ -21,16 +21,27 @@
 #include <stdlib.h>
 #include <time.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <vector>
+
 #include "include/extension.h"
 #include "unicode/locid.h"
 #include "unicode/timezone.h"
 #include "v8/include/v8.h"
 
 int RunV8Code(int argc, int args, char** argv);
+int RunInIsolates(int threads, int argc, int args, char** argv);
 v8::Local<v8::Context> CreateContext(v8::Isolate* isolate);
 bool ExecuteString(v8::Handle<v8::String> source, v8::Handle<v8::Value> name);
 void ReportException(v8::TryCatch* handler);
 v8::Handle<v8::String> ReadFile(const char* name);
+bool ReadBinaryFile(const char* name, std::vector<uint8_t>* data);
+v8::Local<v8::Uint8Array> NewUint8Array(const std::vector<uint8_t>& data);
 const char* ToCString(const v8::String::Utf8Value& value);
 void GetDefaultLocale(const v8::FunctionCallbackInfo<v8::Value>& args);
 void GetDefaultTimeZone(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -39,27 +50,90 @@ void Usage();
 
 const int kMinArgs = 2;
 
+// Compiled break rules registered with -b, and collator image registered
+// with -o. Tests get them as registeredBreakRules and
+// registeredCollatorRules.
+std::vector<uint8_t> break_rules;
+std::vector<uint8_t> collator_rules;
+
 int main(int argc, char* argv[]) {
-  // Parse flags.
-  int count = 0;
-  int args = 1;
   if (argc < kMinArgs) {
     Usage();
     return 1;
-  } else if (!strcmp(argv[1], "-t") && argc > kMinArgs) {
-    args = kMinArgs + 1;
-    count = strtol(argv[2], NULL, 10);
-    if (count == 0) {
+  }
+
+  // Parse flags. Each takes a positive number, except for -b and -o which
+  // take a file name.
+  int count = 0;
+  int threads = 0;
+  int disposals = 0;
+  int cache_size = 0;
+  int args = 1;
+  while (args < argc && argv[args][0] == '-') {
+    if (!strcmp(argv[args], "-b") && args + 1 < argc) {
+      // Registered like an embedder would, before any isolate starts.
+      if (!ReadBinaryFile(argv[args + 1], &break_rules) ||
+          !v8_i18n::Extension::RegisterBreakRules(&break_rules[0],
+                                                  break_rules.size())) {
+        printf("Couldn't register break rules: %s\n", argv[args + 1]);
+        return 1;
+      }
+      args += 2;
+      continue;
+    }
+    if (!strcmp(argv[args], "-o") && args + 1 < argc) {
+      if (!ReadBinaryFile(argv[args + 1], &collator_rules) ||
+          !v8_i18n::Extension::RegisterCollatorRules(&collator_rules[0],
+                                                     collator_rules.size())) {
+        printf("Couldn't register collator rules: %s\n", argv[args + 1]);
+        return 1;
+      }
+      args += 2;
+      continue;
+    }
+
+    int* value = NULL;
+    if (!strcmp(argv[args], "-t")) {
+      value = &count;
+    } else if (!strcmp(argv[args], "-j")) {
+      value = &threads;
+    } else if (!strcmp(argv[args], "-d")) {
+      value = &disposals;
+    } else if (!strcmp(argv[args], "-c")) {
+      value = &cache_size;
+    }
+    if (!value || args + 1 >= argc) {
       Usage();
       return 1;
     }
-  } else if (!strcmp(argv[1], "-t")) {
-    Usage();
-    return 1;
+    *value = strtol(argv[args + 1], NULL, 10);
+    int modes = (count != 0) + (threads != 0) + (disposals != 0);
+    if (*value <= 0 || modes > 1) {
+      Usage();
+      return 1;
+    }
+    args += 2;
+  }
+
+  if (cache_size != 0) {
+    v8_i18n::Extension::SetBreakIteratorCacheSize(cache_size);
   }
 
+  // Extension has to be registered before isolates start on other threads.
+  v8::RegisterExtension(v8_i18n::Extension::get());
+
   int status = 0;
-  if (count != 0) {
+  if (threads != 0) {
+    status = RunInIsolates(threads, argc, args, argv);
+  } else if (disposals != 0) {
+    // Wrappers of a run outlive the extension's data until the garbage
+    // collection that follows, and release what they use only then.
+    for (int i = 0; i < disposals && status == 0; ++i) {
+      status = RunV8Code(argc, args, argv);
+      v8_i18n::Extension::DisposeIsolateData(v8::Isolate::GetCurrent());
+      v8::V8::LowMemoryNotification();
+    }
+  } else if (count != 0) {
     clock_t start = clock();
     for (int i = 0; i < count; ++i) {
       status = RunV8Code(argc, args, argv);
@@ -71,6 +145,7 @@ int main(int argc, char* argv[]) {
     status = RunV8Code(argc, args, argv);
   }
 
+  v8_i18n::Extension::DisposeIsolateData(v8::Isolate::GetCurrent());
   v8::V8::Dispose();
 
   return status;
@@ -91,6 +166,15 @@ int RunV8Code(int argc, int args, char* argv[]) {
 
   context->Enter();
 
+  if (!break_rules.empty()) {
+    context->Global()->Set(v8::String::New("registeredBreakRules"),
+                           NewUint8Array(break_rules));
+  }
+  if (!collator_rules.empty()) {
+    context->Global()->Set(v8::String::New("registeredCollatorRules"),
+                           NewUint8Array(collator_rules));
+  }
+
   int status = 0;
   for (int i = args; i < argc; ++i) {
     v8::Handle<v8::String> source = ReadFile(argv[i]);
@@ -110,6 +194,94 @@ int RunV8Code(int argc, int args, char* argv[]) {
   return status;
 }
 
+// Files to run in one isolate, and the result.
+struct IsolateTask {
+  int argc;
+  int args;
+  char** argv;
+  int status;
+};
+
+// Runs the files in a new isolate, then disposes of the extension's data
+// and of the isolate.
+void RunIsolateTask(IsolateTask* task) {
+  v8::Isolate* isolate = v8::Isolate::New();
+  {
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolate_scope(isolate);
+    task->status = RunV8Code(task->argc, task->args, task->argv);
+    v8_i18n::Extension::DisposeIsolateData(isolate);
+  }
+  isolate->Dispose();
+}
+
+#if defined(_WIN32)
+DWORD WINAPI IsolateThreadMain(LPVOID task) {
+  RunIsolateTask(static_cast<IsolateTask*>(task));
+  return 0;
+}
+#else
+void* IsolateThreadMain(void* task) {
+  RunIsolateTask(static_cast<IsolateTask*>(task));
+  return NULL;
+}
+#endif
+
+// Runs the files concurrently, in |threads| isolates, one per thread.
+// Returns 1 if any of them fails, or if a thread can't be started.
+int RunInIsolates(int threads, int argc, int args, char* argv[]) {
+  std::vector<IsolateTask> tasks(threads);
+#if defined(_WIN32)
+  std::vector<HANDLE> handles(threads, static_cast<HANDLE>(NULL));
+#else
+  std::vector<pthread_t> handles(threads);
+  std::vector<bool> started(threads, false);
+#endif
+
+  int status = 0;
+  for (int i = 0; i < threads; ++i) {
+    tasks[i].argc = argc;
+    tasks[i].args = args;
+    tasks[i].argv = argv;
+    tasks[i].status = 1;
+#if defined(_WIN32)
+    handles[i] = CreateThread(NULL, 0, &IsolateThreadMain, &tasks[i], 0, NULL);
+    if (!handles[i]) {
+      printf("Couldn't start test thread %d.\n", i);
+      status = 1;
+    }
+#else
+    started[i] =
+        pthread_create(&handles[i], NULL, &IsolateThreadMain, &tasks[i]) == 0;
+    if (!started[i]) {
+      printf("Couldn't start test thread %d.\n", i);
+      status = 1;
+    }
+#endif
+  }
+
+  for (int i = 0; i < threads; ++i) {
+#if defined(_WIN32)
+    if (!handles[i]) {
+      continue;
+    }
+    WaitForSingleObject(handles[i], INFINITE);
+    CloseHandle(handles[i]);
+#else
+    if (!started[i]) {
+      continue;
+    }
+    pthread_join(handles[i], NULL);
+#endif
+    if (tasks[i].status != 0) {
+      printf("Test thread %d failed.\n", i);
+      status = 1;
+    }
+  }
+
+  return status;
+}
+
 // Creates global javascript context with our extension loaded.
 v8::Local<v8::Context> CreateContext(v8::Isolate* isolate) {
   v8::Handle<v8::ObjectTemplate> global = v8::ObjectTemplate::New();
@@ -121,9 +293,7 @@ v8::Local<v8::Context> CreateContext(v8::Isolate* isolate) {
   global->Set(v8::String::New("print"),
               v8::FunctionTemplate::New(Print));
 
-  v8::Extension* extension = v8_i18n::Extension::get();
-  v8::RegisterExtension(extension);
-  const char* extension_names[] = {extension->name()};
+  const char* extension_names[] = {v8_i18n::Extension::get()->name()};
   v8::ExtensionConfiguration extensions(1, extension_names);
 
   return v8::Context::New(isolate, &extensions, global);
@@ -219,6 +389,36 @@ v8::Handle<v8::String> ReadFile(const char* name) {
   return result;
 }
 
+// Reads a whole file. Returns false if it can't be read, or is empty.
+bool ReadBinaryFile(const char* name, std::vector<uint8_t>* data) {
+  FILE* file = fopen(name, "rb");
+  if (file == NULL) return false;
+
+  fseek(file, 0, SEEK_END);
+  int size = ftell(file);
+  rewind(file);
+
+  data->resize(size > 0 ? size : 0);
+  for (int i = 0; i < size;) {
+    int read = fread(&(*data)[i], 1, size - i, file);
+    if (read <= 0) break;
+    i += read;
+  }
+  fclose(file);
+
+  return !data->empty();
+}
+
+// Creates an Uint8Array with a copy of |data|.
+v8::Local<v8::Uint8Array> NewUint8Array(const std::vector<uint8_t>& data) {
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(data.size());
+  v8::Local<v8::Uint8Array> array =
+      v8::Uint8Array::New(buffer, 0, data.size());
+  memcpy(array->GetIndexedPropertiesExternalArrayData(), &data[0],
+         data.size());
+  return array;
+}
+
 // Extracts a C string from a V8 Utf8Value.
 const char* ToCString(const v8::String::Utf8Value& value) {
   return *value ? *value : "<string conversion failed>";
@@ -304,7 +504,17 @@ void Print(const v8::FunctionCallbackInfo<v8::Value>& args) {
 
 // Prints program usage.
 void Usage() {
-  printf("Usage:\n\ttest-runner [-t count] [file1 file2 ... fileN]\n");
+  printf("Usage:\n\ttest-runner [-t count | -j threads | -d runs] "
+         "[-c size] [-b file] [-o file] [file1 file2 ... fileN]\n");
   printf("\t-t count - Do a perf run count times.\n");
+  printf("\t-j threads - Run files concurrently, in an isolate per thread.\n");
+  printf("\t-d runs - Run files runs times, disposing of the extension's "
+         "data after each.\n");
+  printf("\t-c size - Cache segmentations of size texts per break "
+         "iterator locale and type.\n");
+  printf("\t-b file - Register compiled break rules from file, and expose "
+         "them as registeredBreakRules.\n");
+  printf("\t-o file - Register collator image from file, and expose it as "
+         "registeredCollatorRules.\n");
   printf("\tfile1...N - Load and execute listed files in that order.\n");
 }
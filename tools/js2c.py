@@ -38,6 +38,15 @@ def RemoveCommentsAndTrailingWhitespace(lines):
   return lines
 
 
+def Minify(lines):
+  # Comments and trailing whitespace are gone already. Indentation is dead
+  # weight too, for the scanner and for the binary. Line breaks stay, so we
+  # don't have to worry about automatic semicolon insertion.
+  lines = re.sub(r'\n[ \t]+', '\n', lines)
+  lines = re.sub(r'^[ \t]+', '', lines)
+  return lines
+
+
 def ReadFile(filename):
   file = open(filename, "rt")
   try:
@@ -75,25 +84,46 @@ HEADER_TEMPLATE = """\
 
 namespace v8_i18n {
 
+// JavaScript source gets injected here.
+static const char api_source[] = {%s};
+
 // static
 const char* Natives::GetScriptSource() {
-  // JavaScript source gets injected here.
-  static const char api_source[] = {%s};
-
   return api_source;
 }
 
+// static
+int Natives::GetScriptSourceLength() {
+  return sizeof(api_source) - 1;
+}
+
 }  // v8_i18n
 """
 
 
-def JS2C(source_files, target_file, combined_js_files):
+LAZY_SERVICE_TEMPLATE = """\
+addLazyService('%s', function() {
+%s
+});
+"""
+
+
+def WrapLazyService(lines, filename):
+  # Service code runs, and gets fully compiled, only when its constructor
+  # is first used. See addLazyService in src/utils.js.
+  service = os.path.splitext(os.path.basename(filename))[0]
+  return LAZY_SERVICE_TEMPLATE % (service, lines)
+
+
+def JS2C(source_files, target_file, combined_js_files, lazy_files):
   all_lines = []
   for source in source_files:
     filename = str(source)
     lines = ReadFile(filename)
     lines = Validate(lines, filename)
-    all_lines.extend(lines)
+    if filename in lazy_files:
+      lines = WrapLazyService(lines, filename)
+    all_lines.extend(Minify(lines))
   data = ToCArray(all_lines)
 
   # Emit result
@@ -109,7 +139,16 @@ def main():
   target_file = sys.argv[1]
   combined_js_files = sys.argv[2]
   source_files = sys.argv[3:]
-  JS2C(source_files, target_file, combined_js_files)
+
+  # Files listed between --lazy and -- are services that get installed on
+  # first use. They have to be listed among the source files too.
+  lazy_files = []
+  if source_files and source_files[0] == '--lazy':
+    end = source_files.index('--')
+    lazy_files = source_files[1:end]
+    source_files = source_files[end + 1:]
+
+  JS2C(source_files, target_file, combined_js_files, lazy_files)
 
 
 if __name__ == "__main__":